@@ -71,13 +71,16 @@ source_files = [
     "arraydynamictest.tx",
     "arrayinittest.tx",
     "arraymodifiability.tx",
+    "arrayrangetest.tx",
 
     "lookuptest.tx",
     "membertest.tx",
     "membermodifiability.tx",
     "polymorphtest.tx",
+    "callbindingtest.tx",
     "recursivetypetest.tx",
     "constructiontest.tx",
+    "layouttest.tx",
     "interfacetest.tx",
     "interfaceadaptertest.tx",
     "nestedtypestest.tx",
@@ -95,10 +98,112 @@ source_files = [
     "genericconvtest.tx",
 
     "matrixtest.tx",
+    "vectortest.tx",
+    "constevaltest.tx",
 ]
 
 for src in source_files:
     run_cmd( """txc -quiet -jit -nobc -notx %s""" % ( src, ) )
 
+# the tuple field layouts in the -dt output of layouttest.tx (size, alignment, padding bytes, type):
+# Mixed is reordered to have no padding (in declaration order it would have 16 padding bytes),
+# SubMixed keeps Mixed as its prefix and reorders its own fields, and the externc CLayout is not reordered.
+layout_lines = [
+    "24 +8 +0 +(.*[ .])?Mixed",
+    "40 +8 +3 +(.*[ .])?SubMixed",
+    "24 +8 +14 +(.*[ .])?CLayout",
+]
+
+for line in layout_lines:
+    run_cmd( """txc -quiet -nojit -nobc -notx -dt layouttest.tx | grep -Eq '^ *[0-9]+ +%s *$'""" % ( line, ) )
+
+# statically bound calls are direct calls in the generated IR, and pure functions are marked readnone:
+callbinding_ir_patterns = [
+    r"call .*Cube\.area\$func",            # method of a leaf type
+    r"call .*Shape\.double_size\$func",    # final method
+    r"call .*Square\.area\$func",          # super.area()
+    r"^attributes #[0-9]+ = \{.*readnone",  # squared()
+]
+
+for pattern in callbinding_ir_patterns:
+    run_cmd( """txc -quiet -nojit -nobc -notx -di callbindingtest.tx | grep -Eq '%s'""" % ( pattern, ) )
+
+# a failed assert reports its own source line, also among several asserts in the same function:
+run_cmd( r"""printf 'check( x : Int ) {\n    assert x > 0;\n    assert x > 1;\n    assert x > 2;\n}\nmain() { check( 2 ); }\n' | txc -quiet -jit -nobc -notx 2>&1 | grep -q ':4: Assertion failed'""" )
+
+# reference-heavy tests are also run with the thin reference representation:
+thinref_source_files = [
+    "reftest.tx",
+    "recursivetypetest.tx",
+    "polymorphtest.tx",
+    "typecasting.tx",
+    "equalstest.tx",
+    "arrayrangetest.tx",
+]
+
+for src in thinref_source_files:
+    run_cmd( """txc -quiet -jit -nobc -notx -thinrefs %s""" % ( src, ) )
+
+# a few tests are also compiled with debug info (and verified, since the verifier checks the debug info):
+debuginfo_source_files = [
+    "funcrecursetest.tx",
+    "arraybasictest.tx",
+    "whiletest.tx",
+    "polymorphtest.tx",
+]
+
+for src in debuginfo_source_files:
+    run_cmd( """txc -quiet -jit -nobc -notx -ver -g %s""" % ( src, ) )
+
+jitprofile_source_files = [
+    "funcrecursetest.tx",
+    "polymorphtest.tx",
+]
+
+for src in jitprofile_source_files:
+    run_cmd( """txc -quiet -jit -nobc -notx -jit-profile -g %s""" % ( src, ) )
+
+profile_source_files = [
+    "polymorphtest.tx",
+    "arraybasictest.tx",
+]
+
+for src in profile_source_files:
+    run_cmd( """txc -quiet -jit -nobc -notx -ver -profile %s""" % ( src, ) )
+
+# the flat profile written to tx-profile.txt lists each function's call count (the fourth column) and name:
+profile_lines = [
+    r"11  ([^ ]*\.)?recurse",
+    r"6  ([^ ]*\.)?cross_recurse_pos",
+    r"5  ([^ ]*\.)?cross_recurse_neg",
+]
+
+run_cmd( """txc -quiet -jit -nobc -notx -profile funcrecursetest.tx""" )
+for line in profile_lines:
+    run_cmd( """grep -Eq '^ *[0-9.]+ +[0-9]+ +[0-9]+ +%s$' tx-profile.txt""" % ( line, ) )
+run_cmd( """rm -f tx-profile.txt""" )
+
+# (PGO instrumented code can't be run in JIT mode, only its verification is tested)
+run_cmd( """txc -quiet -nojit -nobc -notx -ver -fprofile-generate polymorphtest.tx""" )
+run_cmd( """txc -quiet -nojit -nobc -notx -fprofile-use=nonexistent.profdata polymorphtest.tx""", "nonzero" )
+
+heapprof_source_files = [
+    "arraybasictest.tx",
+    "polymorphtest.tx",
+]
+
+for src in heapprof_source_files:
+    run_cmd( """txc -quiet -jit -nobc -notx -ver -heapprof %s""" % ( src, ) )
+
+# the heap profile is printed to stderr, with the allocation count and bytes in total and per type:
+heapprof_src = "main() { a := new Int( 1 ); b := new Int( 2 ); c := new Int( 3 ); }"
+heapprof_lines = [
+    r"Heap profile: 3 allocations, [0-9]+ bytes",
+    r" +3 +[0-9]+  ([^ ]*\.)?Int",
+]
+
+for line in heapprof_lines:
+    run_cmd( """echo "%s" | txc -quiet -jit -nobc -notx -heapprof 2>&1 >/dev/null | grep -Eq '^%s$'""" % ( heapprof_src, line ) )
+
 #for src in source_files:
 #    run_cmd( """txc -quiet -jit -nobc -tx ../.. %s""" % ( src, ) )
@@ -35,11 +35,27 @@ source_files = [
     "array_equals.tx",
     "array_interface.tx",
     "string_test.tx",
+    "growable_test.tx",
+    "outstream_test.tx",
+    "hashmap_test.tx",
+    "sort_test.tx",
     "scalars_test.tx",
     "for_loops.tx",
     "format_test.tx",
     "equality_test.tx",
+    "dataspace_test.tx",
 ]
 
 for src in source_files:
     run_cmd( """txc -quiet -jit -nobc -tx ../../ %s""" % ( src, ) )
+
+# dataspace misuse panics: entering an entered dataspace, and releasing an entered dataspace shadowed by a nested one
+run_cmd( """echo "main() { ds := ~ tx.Dataspace(); ds.enter(); ds.enter(); }" | txc -quiet -jit -nobc -tx ../../ >/dev/null""", "nonzero" )
+run_cmd( """echo "main() { a := ~ tx.Dataspace(); b := ~ tx.Dataspace(); a.enter(); b.enter(); a.release(); }" | txc -quiet -jit -nobc -tx ../../ >/dev/null""", "nonzero" )
+
+gc_source_files = [
+    "gc_test.tx",
+]
+
+for src in gc_source_files:
+    run_cmd( """txc -quiet -jit -nobc -gc -tx ../../ %s""" % ( src, ) )
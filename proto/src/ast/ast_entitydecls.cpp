@@ -176,10 +176,11 @@ void TxFieldDeclNode::symbol_resolution_pass() {
                 CERROR( this, "Global/static fields must have an initializer: " << this->fieldDef->get_descriptor() );
             // FUTURE: When static initializers in types are supported, static/virtual fields' initialization may be deferred.
         }
-        else {
-            // field is expected to have a statically constant initializer
-            if ( !this->fieldDef->initExpression->is_statically_constant() )
-                CERROR( this, "Non-constant initializer for global/static field " << this->fieldDef->fieldName );
+        else if ( !this->fieldDef->initExpression->is_statically_constant() ) {
+            // non-constant initializers are run at program start (unless they can be evaluated at code generation)
+            if ( !type->type()->is_static() )
+                CERROR( this, "Global/static field with non-constant initializer must be of static type: "
+                        << this->fieldDef->get_descriptor() << " : " << type );
         }
         break;
     default:
@@ -66,6 +66,7 @@ void TxLocalFieldDefNode::code_gen_field( LlvmGenerationContext& context, GenSco
         // We don't automatically invoke default constructor (in future, a code flow validator should check that initialized before first use)
     }
     this->get_field()->set_llvm_value( fieldPtrV );
+    context.gen_debug_variable( scope, this, this->declaration->get_symbol()->get_name(), acttype, fieldPtrV );
 }
 
 
@@ -101,6 +102,15 @@ static Value* make_constant_nonlocal_field( LlvmGenerationContext& context, Type
     return globalV;
 }
 
+static Value* make_initialized_nonlocal_field( LlvmGenerationContext& context, Type* llvmType, const std::string& name ) {
+    // zero-initialized storage, assigned by the static initialization function at program start
+    auto globalV = cast<GlobalVariable>( context.llvmModule().getOrInsertGlobal( name, llvmType ) );
+    globalV->setLinkage( GlobalValue::InternalLinkage );
+    ASSERT( !globalV->hasInitializer(), "global already has initializer: " << globalV );
+    globalV->setInitializer( Constant::getNullValue( llvmType ) );
+    return globalV;
+}
+
 void TxNonLocalFieldDefNode::inner_code_gen_field( LlvmGenerationContext& context, bool genBody ) const {
     TRACE_CODEGEN( this, context );
     if ( this->typeExpression )
@@ -174,7 +184,13 @@ void TxNonLocalFieldDefNode::inner_code_gen_field( LlvmGenerationContext& contex
                                                                                      constantInitializer, uniqueName ) );
                     return;
                 }
-                // TODO: support non-constant initializers for static and virtual fields
+                if ( fieldDecl->get_storage() != TXS_VIRTUAL ) {
+                    this->get_field()->set_llvm_value( make_initialized_nonlocal_field( context, context.get_llvm_type( txType ),
+                                                                                        uniqueName ) );
+                    context.add_static_initializer( this );
+                    return;
+                }
+                // TODO: support non-constant initializers for virtual fields
             }
             LOG( context.LOGGER(), WARN, "Skipping codegen for global/static/virtual field without constant initializer: " << uniqueName );
         }
@@ -13,6 +13,7 @@ class GenScope;
 namespace llvm {
 class Constant;
 class Value;
+class MDNode;
 }
 
 
@@ -311,6 +311,8 @@ public:
 
     virtual llvm::Value* code_gen_address( LlvmGenerationContext& context, GenScope* scope ) const override;
 
+    virtual llvm::MDNode* get_tbaa_tag( LlvmGenerationContext& context ) const override;
+
     virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
         this->array->visit_ast( visitor, thisCursor, "array", context );
     }
@@ -1,4 +1,5 @@
 #include "ast_array.hpp"
+#include "ast_consteval.hpp"
 
 #include "ast/stmt/ast_stmt_node.hpp"
 #include "parsercontext.hpp"
@@ -180,6 +181,7 @@ static Value* gen_elem_address( LlvmGenerationContext& context, GenScope* scope,
     ASSERT( scope, "NULL scope in non-const array elem access");
     if ( panicNode ) {
         // add bounds check
+        context.gen_profile_bounds_check( scope );
         auto parentFunc = scope->builder->GetInsertBlock()->getParent();
         BasicBlock* trueBlock = BasicBlock::Create( context.llvmContext, "if_true", parentFunc );
         BasicBlock* postBlock = BasicBlock::Create( context.llvmContext, "if_post", parentFunc );
@@ -187,9 +189,10 @@ static Value* gen_elem_address( LlvmGenerationContext& context, GenScope* scope,
         Value* lenIxs[] = { ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ),
                             ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 1 ) };
         auto lengthPtrV = scope->builder->CreateInBoundsGEP( arrayPtrV, lenIxs );
-        auto lengthV = scope->builder->CreateLoad( lengthPtrV );
+        auto lengthV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( lengthPtrV ), context.get_tbaa_array_header_tag( 1 ) );
         auto condV = scope->builder->CreateICmpUGE( subscriptV, lengthV );
-        scope->builder->CreateCondBr( condV, trueBlock, postBlock );
+        // (for assignments, writing one slot past the end is a valid append)
+        scope->builder->CreateCondBr( condV, trueBlock, postBlock, ( isAssignment ? nullptr : context.get_panic_branch_weights() ) );
 
         scope->builder->SetInsertPoint( trueBlock );
         if ( isAssignment ) {
@@ -198,22 +201,22 @@ static Value* gen_elem_address( LlvmGenerationContext& context, GenScope* scope,
             BasicBlock* okCapBlock  = BasicBlock::Create( context.llvmContext, "if_ok_cap",   parentFunc );
             BasicBlock* panicBlock  = BasicBlock::Create( context.llvmContext, "if_else_panic", parentFunc );
             auto condAsmtV = scope->builder->CreateICmpEQ( subscriptV, lengthV );
-            scope->builder->CreateCondBr( condAsmtV, okIncrBlock, panicBlock );
+            scope->builder->CreateCondBr( condAsmtV, okIncrBlock, panicBlock, context.get_panic_branch_weights( false ) );
 
             { // check capacity:
                 scope->builder->SetInsertPoint( okIncrBlock );
                 Value* capIxs[] = { ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ),
                                     ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ) };
                 auto capPtrV = scope->builder->CreateInBoundsGEP( arrayPtrV, capIxs );
-                auto capV = scope->builder->CreateLoad( capPtrV );
+                auto capV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( capPtrV ), context.get_tbaa_array_header_tag( 0 ) );
                 auto condCapV = scope->builder->CreateICmpULT( subscriptV, capV );
-                scope->builder->CreateCondBr( condCapV, okCapBlock, panicBlock );
+                scope->builder->CreateCondBr( condCapV, okCapBlock, panicBlock, context.get_panic_branch_weights( false ) );
             }
 
             { // increment length:
                 scope->builder->SetInsertPoint( okCapBlock );
                 auto newLenV = scope->builder->CreateAdd( lengthV, ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 1 ) );
-                scope->builder->CreateStore( newLenV, lengthPtrV );
+                LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateStore( newLenV, lengthPtrV ), context.get_tbaa_array_header_tag( 1 ) );
                 scope->builder->CreateBr( postBlock );
             }
 
@@ -248,7 +251,7 @@ Value* TxElemDerefNode::code_gen_dyn_value( LlvmGenerationContext& context, GenS
     Value* elemPtr = gen_elem_address( context, scope, this->array->code_gen_dyn_address( context, scope ),
                                        this->subscript->code_gen_dyn_value( context, scope ), this->panicNode, false );
     if ( scope )
-        return scope->builder->CreateLoad( elemPtr );
+        return LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( elemPtr ), context.get_tbaa_tag( this->qualtype()->type()->acttype() ) );
     else
         return new LoadInst( elemPtr );
 }
@@ -276,12 +279,15 @@ Constant* TxElemDerefNode::code_gen_const_value( LlvmGenerationContext& context
     auto arrayC = this->array->code_gen_const_value( context );
     auto subscriptC = cast<ConstantInt>( this->subscript->code_gen_const_value( context ) );
 
+    uint64_t index = subscriptC->getZExtValue();
     if (this->panicNode) {
-        uint64_t index = cast<ConstantInt>( subscriptC )->getZExtValue();
         uint64_t length = cast<ConstantInt>( arrayC->getAggregateElement( 1 ) )->getZExtValue();
         if ( index >= length )
-            CERR_CODECHECK( this, "Constant array index out of bounds: " << index << " >= " << length );
+            const_eval_fail( this, "Constant array index out of bounds: " + std::to_string( index )
+                                   + " >= " + std::to_string( length ) );
     }
+    else if ( index >= arrayC->getType()->getStructElementType( 2 )->getArrayNumElements() )
+        const_eval_fail( this, "Constant array index out of bounds: " + std::to_string( index ) );
 
     uint32_t ixs[] = { 2, (uint32_t) subscriptC->getLimitedValue( UINT32_MAX ) };
     return ConstantExpr::getExtractValue( arrayC, ixs );
@@ -301,3 +307,7 @@ Value* TxArrayLenAssigneeNode::code_gen_address( LlvmGenerationContext& context,
     auto lengthPtrV = scope->builder->CreateInBoundsGEP( arrayPtrV, lenIxs );
     return lengthPtrV;
 }
+
+MDNode* TxArrayLenAssigneeNode::get_tbaa_tag( LlvmGenerationContext& context ) const {
+    return context.get_tbaa_array_header_tag( 1 );
+}
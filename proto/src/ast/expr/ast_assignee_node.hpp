@@ -34,4 +34,8 @@ public:
 
     /** Generates code that produces the type id of this assignee. */
     virtual llvm::Value* code_gen_typeid( LlvmGenerationContext& context, GenScope* scope ) const;
+
+    /** Returns the TBAA access tag for stores to this assignee (null if untagged).
+     * Must match the tag of the loads of the same storage. */
+    virtual llvm::MDNode* get_tbaa_tag( LlvmGenerationContext& context ) const;
 };
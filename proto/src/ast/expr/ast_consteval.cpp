@@ -0,0 +1,186 @@
+#include "ast_consteval.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast_exprs.hpp"
+#include "ast_field.hpp"
+#include "ast_lambda_node.hpp"
+#include "ast_op_exprs.hpp"
+#include "ast_conv.hpp"
+#include "ast_array.hpp"
+
+#include "ast/stmt/ast_stmts.hpp"
+#include "ast/stmt/ast_flow.hpp"
+#include "ast/stmt/ast_assertstmt_node.hpp"
+#include "ast/stmt/ast_panicstmt_node.hpp"
+#include "ast/type/ast_typeexpr_node.hpp"
+
+#include "symbol/qual_type.hpp"
+#include "symbol/type_registry.hpp"
+
+
+enum TxPurity {
+    TXP_ANALYZING,  // analysis in progress (assumed pure by recursive invocations)
+    TXP_PURE,
+    TXP_IMPURE,
+};
+
+/** The purity of the analyzed functions. Functions that are found pure while assuming the purity of
+ * a function still being analyzed are only recorded once the outermost analysis completes. */
+static std::unordered_map<const TxLambdaExprNode*, TxPurity> functionPurity;
+static unsigned analysisDepth = 0;
+
+struct PurityCheck {
+    /** nodes whose subtrees are not examined (type expressions, constant expressions, panics, pure callees) */
+    std::unordered_set<const TxNode*> acceptedRoots;
+    bool impure = false;
+    bool unresolved = false;
+};
+
+static bool is_pure_expression( const TxExpressionNode* expr, PurityCheck* check ) {
+    if ( auto callNode = dynamic_cast<const TxFunctionCallNode*>( expr ) ) {
+        if ( !callNode->is_statically_constant() ) {
+            if ( callNode->get_inlined_expression() )
+                return true;  // (the inlined expression is examined as the call's descendant)
+            if ( !get_pure_callee( callNode, true ) )
+                return false;
+            check->acceptedRoots.insert( callNode->callee );
+            return true;
+        }
+    }
+
+    if ( expr->is_statically_constant() ) {
+        if ( expr->qualtype()->get_type_class() == TXTC_FUNCTION )
+            return false;  // (generating a function value isn't free of side effects)
+        check->acceptedRoots.insert( expr );
+        return true;
+    }
+
+    if ( auto fieldNode = dynamic_cast<const TxFieldValueNode*>( expr ) ) {
+        auto field = fieldNode->get_field();
+        if ( !field )
+            return false;
+        if ( field->get_storage() == TXS_STACK )
+            return true;  // local field or argument
+        if ( field->get_storage() == TXS_INSTANCE )
+            return ( fieldNode->baseExpr && fieldNode->baseExpr->qualtype()->get_type_class() == TXTC_ARRAY );  // C and L
+        return false;
+    }
+
+    if ( auto eqNode = dynamic_cast<const TxEqualityOperatorNode*>( expr ) )
+        return ( eqNode->lhs->qualtype()->get_type_class() == TXTC_ELEMENTARY );
+
+    return ( dynamic_cast<const TxBinaryElemOperatorNode*>( expr )
+             || dynamic_cast<const TxUnaryMinusNode*>( expr )
+             || dynamic_cast<const TxUnaryLogicalNotNode*>( expr )
+             || dynamic_cast<const TxMaybeConversionNode*>( expr )
+             || dynamic_cast<const TxScalarConvNode*>( expr )
+             || dynamic_cast<const TxBoolConvNode*>( expr )
+             || dynamic_cast<const TxNoConversionNode*>( expr )
+             || dynamic_cast<const TxElemDerefNode*>( expr ) );
+}
+
+static bool is_pure_node( const TxNode* node, PurityCheck* check ) {
+    if ( dynamic_cast<const TxTypeExpressionNode*>( node ) || dynamic_cast<const TxPanicStmtNode*>( node ) ) {
+        check->acceptedRoots.insert( node );
+        return true;
+    }
+
+    if ( auto expr = dynamic_cast<const TxExpressionNode*>( node ) ) {
+        if ( !expr->attempt_qualtype() ) {
+            check->unresolved = true;
+            return false;
+        }
+        return is_pure_expression( expr, check );
+    }
+
+    if ( auto elemAssignee = dynamic_cast<const TxElemAssigneeNode*>( node ) ) {
+        // only elements of local array fields may be assigned
+        auto arrayField = dynamic_cast<const TxFieldValueNode*>( elemAssignee->array->originalExpr );
+        return ( arrayField && arrayField->get_field() && arrayField->get_field()->get_storage() == TXS_STACK
+                 && arrayField->qualtype()->get_type_class() == TXTC_ARRAY );
+    }
+
+    if ( dynamic_cast<const TxArrayCopyStmtNode*>( node ) )
+        return false;
+
+    return ( dynamic_cast<const TxSuiteNode*>( node )
+             || dynamic_cast<const TxFieldStmtNode*>( node )
+             || dynamic_cast<const TxLocalFieldDefNode*>( node )
+             || dynamic_cast<const TxAssignStmtNode*>( node )
+             || dynamic_cast<const TxFieldAssigneeNode*>( node )  // (the field is examined as its descendant)
+             || dynamic_cast<const TxExprStmtNode*>( node )
+             || dynamic_cast<const TxReturnStmtNode*>( node )
+             || dynamic_cast<const TxBreakStmtNode*>( node )
+             || dynamic_cast<const TxContinueStmtNode*>( node )
+             || dynamic_cast<const TxNoOpStmtNode*>( node )
+             || dynamic_cast<const TxAssertStmtNode*>( node )
+             || dynamic_cast<const TxIfStmtNode*>( node )
+             || dynamic_cast<const TxForStmtNode*>( node )
+             || dynamic_cast<const TxElseClauseNode*>( node )
+             || dynamic_cast<const TxCondClauseNode*>( node )
+             || dynamic_cast<const TxForHeaderNode*>( node ) );
+}
+
+static TxPurity analyze_purity( const TxLambdaExprNode* lambdaExpr, bool* unresolved ) {
+    PurityCheck check;
+    auto visitor = []( TxNode* node, const AstCursor& parent, const std::string& role, void* ctx ) {
+        auto check = static_cast<PurityCheck*>( ctx );
+        if ( check->impure )
+            return;
+        if ( check->acceptedRoots.count( node ) )
+            return;
+        for ( auto cursor = &parent; cursor && cursor->node; cursor = cursor->parent ) {
+            if ( check->acceptedRoots.count( cursor->node ) )
+                return;
+        }
+        if ( !is_pure_node( node, check ) )
+            check->impure = true;
+    };
+    lambdaExpr->suite->visit_ast( visitor, &check );
+    *unresolved = check.unresolved;
+    return ( check.impure ? TXP_IMPURE : TXP_PURE );
+}
+
+const TxLambdaExprNode* get_pure_callee( const TxFunctionCallNode* callNode, bool allowAssumed ) {
+    if ( !callNode->registry().is_preparing_types() )
+        return nullptr;  // only analyzed after the resolution passes
+    auto calleeNode = dynamic_cast<const TxFieldValueNode*>( callNode->callee );
+    if ( !calleeNode || !calleeNode->get_field() || !callNode->attempt_qualtype() )
+        return nullptr;
+    auto field = calleeNode->get_field();
+    auto fieldDecl = field->get_declaration();
+    if ( !( fieldDecl->get_storage() == TXS_GLOBAL || fieldDecl->get_storage() == TXS_STATIC )
+            || ( fieldDecl->get_decl_flags() & ( TXD_EXTERNC | TXD_ABSTRACT ) )
+            || field->qualtype()->is_modifiable() )
+        return nullptr;
+    auto initExpr = static_cast<TxFieldDefNode*>( fieldDecl->get_definer() )->initExpression;
+    if ( !initExpr )
+        return nullptr;
+    auto lambdaExpr = dynamic_cast<const TxLambdaExprNode*>( initExpr->originalExpr );
+    if ( !lambdaExpr || lambdaExpr->is_instance_method() || lambdaExpr->get_constructed()
+            || !lambdaExpr->funcHeaderNode->returnField
+            || lambdaExpr->funcHeaderNode->arguments->size() != callNode->argsExprList->size() )
+        return nullptr;
+
+    auto purityI = functionPurity.find( lambdaExpr );
+    if ( purityI != functionPurity.end() ) {
+        if ( purityI->second == TXP_ANALYZING )
+            return ( allowAssumed ? lambdaExpr : nullptr );
+        return ( purityI->second == TXP_PURE ? lambdaExpr : nullptr );
+    }
+
+    functionPurity[lambdaExpr] = TXP_ANALYZING;
+    analysisDepth++;
+    bool unresolved = false;
+    auto purity = analyze_purity( lambdaExpr, &unresolved );
+    analysisDepth--;
+    if ( unresolved || ( purity == TXP_PURE && analysisDepth > 0 ) )
+        functionPurity.erase( lambdaExpr );  // (determined later)
+    else
+        functionPurity[lambdaExpr] = purity;
+    if ( purity == TXP_PURE && analysisDepth > 0 && !allowAssumed )
+        return nullptr;
+    return ( purity == TXP_PURE ? lambdaExpr : nullptr );
+}
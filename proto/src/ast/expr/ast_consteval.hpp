@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+
+namespace llvm {
+class Constant;
+}
+
+class LlvmGenerationContext;
+class TxNode;
+class TxField;
+class TxFunctionCallNode;
+class TxLambdaExprNode;
+
+
+/* Compile-time evaluation of calls to pure functions.
+ *
+ * A function is pure if it is a global or static (non-method, non-external) function, has a return value,
+ * and its body only consists of:
+ *     local field declarations and assignments, including elements of local arrays,
+ *     elementary operations, conversions, array element and length reads,
+ *     statically constant expressions,
+ *     calls to other pure functions,
+ *     if, while, and C-style for statements, break, continue, return, assert.
+ * Such functions can't observe or modify non-local state, so a call with statically constant arguments
+ * can be evaluated by interpreting the function body on LLVM constants.
+ *
+ * Evaluation is bounded (in number of steps and call depth). If it can't be completed - the bounds are exceeded,
+ * or the function would panic, e.g. on a failed assert, an out-of-bounds array index, or a division by zero -
+ * the call is not considered statically constant and is left to run time.
+ *
+ * Calls are only evaluated once the resolution passes have completed.
+ */
+
+
+/** Returns the function expression of the callee of the specified call if it is a pure function, otherwise null.
+ * @param allowAssumed if true, functions whose purity is currently being analyzed are assumed to be pure
+ *                     (used for recursive functions) */
+const TxLambdaExprNode* get_pure_callee( const TxFunctionCallNode* callNode, bool allowAssumed = false );
+
+/** Returns true if the specified call is to a pure function with statically constant arguments,
+ * and its evaluation at compile time succeeds. The result is memoized. */
+bool is_constant_pure_call( const TxFunctionCallNode* callNode );
+
+/** Returns the result value of a call to a pure function, evaluated at compile time.
+ * The arguments need not be statically constant if invoked within an evaluation in progress. */
+llvm::Constant* eval_pure_call( LlvmGenerationContext& context, const TxFunctionCallNode* callNode );
+
+/** If a compile-time function evaluation is in progress, returns the current value of the specified
+ * local field or argument of the function being evaluated. Otherwise returns null. */
+llvm::Constant* get_const_eval_value( const TxField* field );
+
+/** Fails a constant evaluation, e.g. an array index out of bounds.
+ * If a compile-time function evaluation is in progress it is aborted, and the call is left to run time;
+ * otherwise this generates a compilation error. Does not return. */
+[[noreturn]] void const_eval_fail( const TxNode* origin, const std::string& message );
@@ -0,0 +1,352 @@
+#include "ast_consteval.hpp"
+
+#include <unordered_map>
+
+#include "ast_exprs.hpp"
+#include "ast_field.hpp"
+#include "ast_lambda_node.hpp"
+#include "ast_array.hpp"
+
+#include "ast/stmt/ast_stmts.hpp"
+#include "ast/stmt/ast_flow.hpp"
+#include "ast/stmt/ast_assertstmt_node.hpp"
+#include "ast/stmt/ast_panicstmt_node.hpp"
+
+#include "symbol/qual_type.hpp"
+#include "symbol/package.hpp"
+#include "driver.hpp"
+#include "parsercontext.hpp"
+#include "llvm_generator.hpp"
+
+using namespace llvm;
+
+/** The maximum number of statements, expressions and calls executed by an outermost evaluation. */
+static const uint64_t MAX_EVAL_STEPS = 1000000;
+
+/** The maximum call depth of an evaluation. */
+static const unsigned MAX_EVAL_DEPTH = 256;
+
+
+/** Thrown to abort a compile-time evaluation that can't be completed. Does not generate a compilation error. */
+class const_eval_abort : public compilation_error {
+public:
+    const_eval_abort( const TxParseOrigin* origin, const std::string& errMessage )
+            : compilation_error( origin, errMessage ) { }
+};
+
+enum TxExecResult {
+    TXE_NEXT, TXE_BREAK, TXE_CONTINUE, TXE_RETURN
+};
+
+/** Returns true if the constant is a computed value, i.e. neither an unfolded expression nor (containing)
+ * an undefined value, which is the result of e.g. a division by zero. */
+static bool is_evaluated( const Constant* valueC ) {
+    if ( isa<UndefValue>( valueC ) )
+        return false;
+    if ( isa<GlobalValue>( valueC ) )
+        return true;
+    if ( isa<ConstantExpr>( valueC ) )
+        return valueC->getType()->isPointerTy();  // (e.g. the address of a constant global)
+    for ( auto& operand : valueC->operands() ) {
+        if ( !is_evaluated( cast<Constant>( operand ) ) )
+            return false;
+    }
+    return true;
+}
+
+
+/** Interprets the bodies of pure functions on LLVM constants. */
+class TxConstEvaluator {
+    struct Frame {
+        std::unordered_map<const TxField*, Constant*> values;
+        Constant* returnValue = nullptr;
+    };
+
+    /** the call frames of the evaluations in progress (nested evaluations share the outermost one's step budget) */
+    static std::vector<Frame*> frames;
+    static unsigned evalDepth;
+    static uint64_t steps;
+
+    /** the memoized results of the calls with statically constant arguments (null if not evaluable) */
+    static std::unordered_map<const TxFunctionCallNode*, Constant*> constantCalls;
+
+    [[noreturn]] static void abort( const TxNode* origin, const std::string& message ) {
+        throw const_eval_abort( origin, message );
+    }
+
+    static void step( const TxNode* origin ) {
+        if ( ++steps > MAX_EVAL_STEPS )
+            abort( origin, "Compile-time evaluation exceeded " + std::to_string( MAX_EVAL_STEPS ) + " steps" );
+    }
+
+    static Constant* eval_expr( LlvmGenerationContext& context, const TxExpressionNode* expr ) {
+        step( expr );
+        auto valueC = expr->code_gen_const_value( context );
+        if ( !is_evaluated( valueC ) )
+            abort( expr, "Expression could not be evaluated at compile time" );
+        return valueC;
+    }
+
+    static bool eval_cond( LlvmGenerationContext& context, const TxExpressionNode* condExpr ) {
+        return !eval_expr( context, condExpr )->isNullValue();
+    }
+
+    static void set_value( LlvmGenerationContext& context, const TxNode* origin, const TxField* field, Constant* valueC ) {
+        if ( valueC->getType() != context.get_llvm_type( field->qualtype() ) )
+            abort( origin, "Mismatching value type in compile-time evaluation of " + field->get_unique_name() );
+        frames.back()->values[field] = valueC;
+    }
+
+    /** Returns the initial value of a field declared without initializer; arrays are empty with their capacity set. */
+    static Constant* default_value( LlvmGenerationContext& context, const TxNode* origin, const TxField* field ) {
+        auto llvmType = context.get_llvm_type( field->qualtype() );
+        auto valueC = Constant::getNullValue( llvmType );
+        if ( field->qualtype()->get_type_class() == TXTC_ARRAY ) {
+            auto capacity = llvmType->getStructElementType( 2 )->getArrayNumElements();
+            if ( capacity == 0 )
+                abort( origin, "Arrays of dynamic capacity are not supported in compile-time evaluation" );
+            unsigned capIxs[] = { 0 };
+            valueC = ConstantExpr::getInsertValue( valueC, ConstantInt::get( Type::getInt32Ty( context.llvmContext ), capacity ),
+                                                   capIxs );
+        }
+        return valueC;
+    }
+
+    static void exec_elem_assignment( LlvmGenerationContext& context, const TxElemAssigneeNode* elemAssignee, Constant* valueC ) {
+        auto arrayField = static_cast<const TxFieldValueNode*>( elemAssignee->array->originalExpr )->get_field();
+        auto arrayC = get_value( arrayField );
+        if ( !arrayC )
+            abort( elemAssignee, "Array not initialized in compile-time evaluation" );
+        auto index = cast<ConstantInt>( eval_expr( context, elemAssignee->subscript ) )->getZExtValue();
+        auto capacity = cast<ConstantInt>( arrayC->getAggregateElement( 0U ) )->getZExtValue();
+        auto length = cast<ConstantInt>( arrayC->getAggregateElement( 1U ) )->getZExtValue();
+        // as in the generated code, assigning the element one past the end appends it if the capacity suffices:
+        if ( index > length || index >= capacity )
+            abort( elemAssignee, "Array index out of bounds: " + std::to_string( index ) + " > " + std::to_string( length ) );
+        if ( valueC->getType() != arrayC->getType()->getStructElementType( 2 )->getArrayElementType() )
+            abort( elemAssignee, "Mismatching element type in compile-time evaluation" );
+
+        unsigned elemIxs[] = { 2, (unsigned) index };
+        arrayC = ConstantExpr::getInsertValue( arrayC, valueC, elemIxs );
+        if ( index == length ) {
+            unsigned lenIxs[] = { 1 };
+            arrayC = ConstantExpr::getInsertValue( arrayC, ConstantInt::get( Type::getInt32Ty( context.llvmContext ), length + 1 ),
+                                                   lenIxs );
+        }
+        frames.back()->values[arrayField] = arrayC;
+    }
+
+    static TxExecResult exec_loop( LlvmGenerationContext& context, const TxForStmtNode* forStmt ) {
+        for ( auto header : *forStmt->loopHeaders ) {
+            if ( auto forHeader = dynamic_cast<const TxForHeaderNode*>( header ) )
+                exec( context, forHeader->initStmt );
+            else if ( !dynamic_cast<const TxCondClauseNode*>( header ) )
+                abort( header, "Loop header not supported in compile-time evaluation" );
+        }
+        while ( true ) {
+            bool cond = true;
+            for ( auto header : *forStmt->loopHeaders ) {
+                if ( auto forHeader = dynamic_cast<const TxForHeaderNode*>( header ) )
+                    cond = eval_cond( context, forHeader->nextCond->expr ) && cond;
+                else
+                    cond = eval_cond( context, static_cast<const TxCondClauseNode*>( header )->condExpr ) && cond;
+            }
+            if ( !cond ) {
+                if ( forStmt->elseClause )
+                    return exec( context, forStmt->elseClause->body );
+                return TXE_NEXT;
+            }
+
+            auto result = exec( context, forStmt->body );
+            if ( result == TXE_BREAK )
+                return TXE_NEXT;
+            if ( result == TXE_RETURN )
+                return TXE_RETURN;
+            if ( result == TXE_NEXT ) {
+                // (as in the generated code, continue proceeds directly to the condition)
+                for ( auto header : *forStmt->loopHeaders ) {
+                    if ( auto forHeader = dynamic_cast<const TxForHeaderNode*>( header ) )
+                        exec( context, forHeader->stepStmt );
+                }
+            }
+        }
+    }
+
+    static TxExecResult exec( LlvmGenerationContext& context, const TxStatementNode* stmt ) {
+        step( stmt );
+        if ( auto suiteNode = dynamic_cast<const TxSuiteNode*>( stmt ) ) {
+            for ( auto subStmt : *suiteNode->suite ) {
+                auto result = exec( context, subStmt );
+                if ( result != TXE_NEXT )
+                    return result;
+            }
+            return TXE_NEXT;
+        }
+        else if ( auto fieldStmt = dynamic_cast<const TxFieldStmtNode*>( stmt ) ) {
+            auto fieldDef = fieldStmt->fieldDef;
+            auto valueC = ( fieldDef->initExpression ? eval_expr( context, fieldDef->initExpression )
+                                                     : default_value( context, fieldDef, fieldDef->get_field() ) );
+            set_value( context, fieldDef, fieldDef->get_field(), valueC );
+            return TXE_NEXT;
+        }
+        else if ( auto assignStmt = dynamic_cast<const TxAssignStmtNode*>( stmt ) ) {
+            if ( dynamic_cast<const TxArrayCopyStmtNode*>( stmt ) )
+                abort( stmt, "Array copy not supported in compile-time evaluation" );
+            auto valueC = eval_expr( context, assignStmt->rvalue );
+            if ( auto fieldAssignee = dynamic_cast<const TxFieldAssigneeNode*>( assignStmt->lvalue ) )
+                set_value( context, stmt, fieldAssignee->field->get_field(), valueC );
+            else if ( auto elemAssignee = dynamic_cast<const TxElemAssigneeNode*>( assignStmt->lvalue ) )
+                exec_elem_assignment( context, elemAssignee, valueC );
+            else
+                abort( stmt, "Assignee not supported in compile-time evaluation" );
+            return TXE_NEXT;
+        }
+        else if ( auto exprStmt = dynamic_cast<const TxExprStmtNode*>( stmt ) ) {
+            eval_expr( context, exprStmt->expr );
+            return TXE_NEXT;
+        }
+        else if ( auto returnStmt = dynamic_cast<const TxReturnStmtNode*>( stmt ) ) {
+            frames.back()->returnValue = ( returnStmt->expr ? eval_expr( context, returnStmt->expr ) : nullptr );
+            return TXE_RETURN;
+        }
+        else if ( dynamic_cast<const TxBreakStmtNode*>( stmt ) )
+            return TXE_BREAK;
+        else if ( dynamic_cast<const TxContinueStmtNode*>( stmt ) )
+            return TXE_CONTINUE;
+        else if ( dynamic_cast<const TxNoOpStmtNode*>( stmt ) )
+            return TXE_NEXT;
+        else if ( auto assertStmt = dynamic_cast<const TxAssertStmtNode*>( stmt ) ) {
+            if ( context.tuplexPackage.driver().get_options().suppress_asserts )
+                return TXE_NEXT;
+            return exec( context, assertStmt->ifStmt );
+        }
+        else if ( dynamic_cast<const TxPanicStmtNode*>( stmt ) )
+            abort( stmt, "Panic in compile-time evaluation" );
+        else if ( auto ifStmt = dynamic_cast<const TxIfStmtNode*>( stmt ) ) {
+            auto condClause = dynamic_cast<const TxCondClauseNode*>( ifStmt->header );
+            if ( !condClause )
+                abort( stmt, "If header not supported in compile-time evaluation" );
+            if ( eval_cond( context, condClause->condExpr ) )
+                return exec( context, ifStmt->body );
+            else if ( ifStmt->elseClause )
+                return exec( context, ifStmt->elseClause->body );
+            return TXE_NEXT;
+        }
+        else if ( auto forStmt = dynamic_cast<const TxForStmtNode*>( stmt ) )
+            return exec_loop( context, forStmt );
+        abort( stmt, "Statement not supported in compile-time evaluation" );
+    }
+
+    static Constant* eval_call( LlvmGenerationContext& context, const TxFunctionCallNode* callNode,
+                                const TxLambdaExprNode* lambdaExpr ) {
+        if ( evalDepth >= MAX_EVAL_DEPTH )
+            abort( callNode, "Compile-time evaluation exceeded call depth " + std::to_string( MAX_EVAL_DEPTH ) );
+        if ( evalDepth == 0 )
+            steps = 0;
+        evalDepth++;
+
+        Frame frame;
+        TxExecResult result;
+        try {
+            step( callNode );
+            // the arguments are evaluated in the caller's frame:
+            std::vector<Constant*> argValues;
+            for ( auto argExpr : *callNode->argsExprList )
+                argValues.push_back( eval_expr( context, argExpr ) );
+
+            frames.push_back( &frame );
+            for ( unsigned i = 0; i < argValues.size(); i++ )
+                set_value( context, callNode, lambdaExpr->funcHeaderNode->arguments->at( i )->get_field(), argValues.at( i ) );
+            result = exec( context, lambdaExpr->suite );
+            frames.pop_back();
+        }
+        catch ( ... ) {
+            if ( !frames.empty() && frames.back() == &frame )
+                frames.pop_back();
+            evalDepth--;
+            throw;
+        }
+        evalDepth--;
+
+        if ( result != TXE_RETURN || !frame.returnValue )
+            abort( callNode, "Compile-time evaluation of function didn't return a value" );
+        if ( frame.returnValue->getType() != context.get_llvm_type( callNode->qualtype() ) )
+            abort( callNode, "Mismatching return value type in compile-time evaluation" );
+        return frame.returnValue;
+    }
+
+public:
+    static bool is_evaluating() {
+        return ( evalDepth > 0 );
+    }
+
+    static Constant* get_value( const TxField* field ) {
+        if ( frames.empty() )
+            return nullptr;
+        auto valueI = frames.back()->values.find( field );
+        return ( valueI == frames.back()->values.end() ? nullptr : valueI->second );
+    }
+
+    static bool is_constant_call( const TxFunctionCallNode* callNode ) {
+        auto callI = constantCalls.find( callNode );
+        if ( callI != constantCalls.end() )
+            return callI->second;
+        auto lambdaExpr = get_pure_callee( callNode );
+        if ( !lambdaExpr )
+            return false;
+        for ( auto argExpr : *callNode->argsExprList ) {
+            if ( !argExpr->is_statically_constant() )
+                return false;
+        }
+
+        auto context = callNode->get_parser_context()->get_llvm_gen_context();
+        Constant* resultC = nullptr;
+        try {
+            resultC = eval_call( *context, callNode, lambdaExpr );
+        }
+        catch ( const const_eval_abort& err ) {
+            LOG_DEBUG( context->LOGGER(), "Call not evaluated at compile time: " << callNode << ": " << err.what() );
+        }
+        constantCalls[callNode] = resultC;
+        return resultC;
+    }
+
+    static Constant* eval_pure_call( LlvmGenerationContext& context, const TxFunctionCallNode* callNode ) {
+        auto callI = constantCalls.find( callNode );
+        if ( callI != constantCalls.end() && callI->second )
+            return callI->second;
+        if ( evalDepth == 0 ) {
+            if ( !is_constant_call( callNode ) )
+                CERR_CODECHECK( callNode, "Call can't be evaluated at compile time" );
+            return constantCalls.at( callNode );
+        }
+        auto lambdaExpr = get_pure_callee( callNode );
+        if ( !lambdaExpr )
+            abort( callNode, "Call to function that isn't pure in compile-time evaluation" );
+        return eval_call( context, callNode, lambdaExpr );
+    }
+};
+
+std::vector<TxConstEvaluator::Frame*> TxConstEvaluator::frames;
+unsigned TxConstEvaluator::evalDepth = 0;
+uint64_t TxConstEvaluator::steps = 0;
+std::unordered_map<const TxFunctionCallNode*, Constant*> TxConstEvaluator::constantCalls;
+
+
+bool is_constant_pure_call( const TxFunctionCallNode* callNode ) {
+    return TxConstEvaluator::is_constant_call( callNode );
+}
+
+Constant* eval_pure_call( LlvmGenerationContext& context, const TxFunctionCallNode* callNode ) {
+    return TxConstEvaluator::eval_pure_call( context, callNode );
+}
+
+Constant* get_const_eval_value( const TxField* field ) {
+    return TxConstEvaluator::get_value( field );
+}
+
+void const_eval_fail( const TxNode* origin, const std::string& message ) {
+    if ( TxConstEvaluator::is_evaluating() )
+        throw const_eval_abort( origin, message );
+    CERR_CODECHECK( origin, message );
+}
@@ -3,12 +3,14 @@
 #include "../ast_entitydecls.hpp"
 #include "ast_expr_node.hpp"
 #include "ast_maybe_conv_node.hpp"
+#include "ast_consteval.hpp"
 
 #include "ast/ast_wrappers.hpp"
 #include "ast/type/ast_typearg_node.hpp"
 
 
 /** Generates code for a call to a lambda.
+ * If the lambda's function is statically known (a constant or inserted into the lambda value), this is a direct call.
  * Note, the passed args vector shall contain only the user-passed args (not the closure).
  */
 llvm::Value* gen_lambda_call( LlvmGenerationContext& context, GenScope* scope, llvm::Value* lambdaV,
@@ -59,10 +61,17 @@ public:
         return TXS_NOSTORAGE;
     }
 
+    /** Returns the expression substituting this call (e.g. a built-in conversion), or null if none. */
+    const TxExpressionNode* get_inlined_expression() const {
+        return this->inlinedExpression;
+    }
+
+    /** A call is statically constant if it has a statically constant inlined expression,
+     * or if it is a call to a pure function with statically constant arguments (see ast_consteval.hpp). */
     virtual bool is_statically_constant() const override {
         if ( this->inlinedExpression )
             return this->inlinedExpression->is_statically_constant();
-        return false;
+        return is_constant_pure_call( this );
     }
 
     virtual llvm::Constant* code_gen_const_value( LlvmGenerationContext& context ) const override;
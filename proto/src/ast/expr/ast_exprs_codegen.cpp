@@ -90,8 +90,9 @@ static Value* gen_call( const TxFunctionCallNode* node, LlvmGenerationContext& c
 }
 
 Constant* TxFunctionCallNode::code_gen_const_value( LlvmGenerationContext& context ) const {
-    ASSERT( this->inlinedExpression, "invoked code_gen_constant() on function call that has no inlined expression: " << this );
-    return this->inlinedExpression->code_gen_const_value( context );
+    if ( this->inlinedExpression )
+        return this->inlinedExpression->code_gen_const_value( context );
+    return eval_pure_call( context, this );
 }
 
 Value* TxFunctionCallNode::code_gen_dyn_value( LlvmGenerationContext& context, GenScope* scope ) const {
@@ -163,7 +164,7 @@ Value* TxConstructorCalleeExprNode::gen_func_ptr( LlvmGenerationContext& context
 Value* TxHeapAllocNode::code_gen_dyn_address( LlvmGenerationContext& context, GenScope* scope ) const {
     TRACE_CODEGEN( this, context );
     this->objTypeExpr->code_gen_type( context );
-    return this->qualtype()->type()->acttype()->gen_malloc( context, scope );
+    return this->qualtype()->type()->acttype()->gen_malloc( context, scope, this );
 }
 
 Value* TxStackAllocNode::code_gen_dyn_address( LlvmGenerationContext& context, GenScope* scope ) const {
@@ -222,3 +223,7 @@ Value* TxAssigneeNode::code_gen_typeid( LlvmGenerationContext& context, GenScope
     // default implementation is the statically known type's id; overridden by assignee forms that are dynamically dependent
     return this->qualtype()->type()->acttype()->gen_typeid( context );
 }
+
+MDNode* TxAssigneeNode::get_tbaa_tag( LlvmGenerationContext& context ) const {
+    return context.get_tbaa_tag( this->qualtype()->type()->acttype() );
+}
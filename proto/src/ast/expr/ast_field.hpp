@@ -41,8 +41,9 @@ const TxFieldDeclaration* resolve_constructor( TxExpressionNode* origin, const T
                                                const std::vector<TxExpressionNode*>* arguments );
 
 
-/** Returns an instance method lambda object value. */
-llvm::Value* instance_method_value_code_gen( LlvmGenerationContext& context, GenScope* scope,
+/** Returns an instance method lambda object value.
+ * @param origin the node the method lookup is generated for, or null if it is generated for built-in code */
+llvm::Value* instance_method_value_code_gen( LlvmGenerationContext& context, GenScope* scope, const TxNode* origin,
                                        const TxActualType* staticBaseType, llvm::Value* runtimeBaseTypeIdV, llvm::Value* basePtrV,
                                        const TxActualType* fieldType, const std::string& fieldName,
                                        bool nonvirtualLookup );
@@ -114,6 +115,9 @@ public:
     virtual llvm::Value* code_gen_dyn_address( LlvmGenerationContext& context, GenScope* scope ) const override;
     virtual llvm::Value* code_gen_dyn_value( LlvmGenerationContext& context, GenScope* scope ) const override;
 
+    /** Returns the TBAA access tag for loads and stores of this field (null if untagged). */
+    llvm::MDNode* get_tbaa_tag( LlvmGenerationContext& context ) const;
+
     virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
         if ( this->baseExpr )
             this->baseExpr->visit_ast( visitor, thisCursor, "base", context );
@@ -156,6 +160,8 @@ public:
 
     virtual llvm::Value* code_gen_address( LlvmGenerationContext& context, GenScope* scope ) const override;
 
+    virtual llvm::MDNode* get_tbaa_tag( LlvmGenerationContext& context ) const override;
+
     virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
         this->field->visit_ast( visitor, thisCursor, "field", context );
     }
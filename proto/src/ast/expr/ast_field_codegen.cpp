@@ -1,6 +1,7 @@
 #include "ast_field.hpp"
 #include "ast_ref.hpp"
 #include "ast_lambda_node.hpp"
+#include "ast_consteval.hpp"
 #include "llvm_generator.hpp"
 
 using namespace llvm;
@@ -23,23 +24,67 @@ static Value* virtual_field_addr_code_gen( LlvmGenerationContext& context, GenSc
                      ConstantInt::get( Type::getInt32Ty( context.llvmContext ), fieldIx ) };
     Value* fieldPtr = scope->builder->CreateInBoundsGEP( vtableBase, ixs );
     // vtable stores pointers to globals/statics (except for $adTypeId) so we dereference one step:
-    Value* fieldV = scope->builder->CreateLoad( fieldPtr );
+    Value* fieldV = context.gen_rtti_load( scope, fieldPtr );
     return fieldV;
 }
 
-/** Returns an instance method lambda object value. */
-Value* instance_method_value_code_gen( LlvmGenerationContext& context, GenScope* scope,
+/** Returns the function that a method invocation on the specified static base type resolves to,
+ * if it can be determined statically, i.e. if it is the method in the static base type's vtable.
+ * Returns null if the vtable entry is a placeholder (generic base types and abstract methods).
+ */
+static Constant* static_method_code_gen( LlvmGenerationContext& context, const TxActualType* staticBaseType,
+                                         const std::string& fieldName ) {
+    switch ( staticBaseType->get_type_class() ) {
+    case TXTC_FUNCTION:
+    case TXTC_REFERENCE:
+    case TXTC_INTERFACE:
+        return nullptr;  // (these are looked up in a built-in base type's or adapter's vtable)
+    default:
+        break;
+    }
+    auto vtype = staticBaseType;
+    while ( vtype->is_same_vtable_type() )
+        vtype = vtype->get_semantic_base_type();
+    if ( vtype->is_type_generic() || !vtype->get_virtual_fields().has_field( fieldName ) )
+        return nullptr;
+    auto methodField = vtype->get_virtual_fields().get_field( fieldName );
+    if ( methodField->get_decl_flags() & TXD_ABSTRACT )
+        return nullptr;
+    auto funcC = dyn_cast_or_null<Constant>( methodField->code_gen_field_decl( context ) );
+    if ( !funcC || funcC->isNullValue() )
+        return nullptr;  // suppressed method
+    return funcC;
+}
+
+/** Returns an instance method lambda object value.
+ * If the method can be statically resolved - a non-virtual lookup, a leaf base type, a statically known runtime type,
+ * or a final method - the lambda holds the method function directly instead of loading it from the vtable,
+ * which makes the invocation a direct call.
+ */
+Value* instance_method_value_code_gen( LlvmGenerationContext& context, GenScope* scope, const TxNode* origin,
                                        const TxActualType* staticBaseType, Value* runtimeBaseTypeIdV, Value* basePtrV,
                                        const TxActualType* fieldType, const std::string& fieldName,
                                        bool nonvirtualLookup ) {
     auto lambdaT = cast<StructType>( context.get_llvm_type( fieldType ) );
-    Value* funcPtrV;
-    if ( nonvirtualLookup ) {
-        Value* staticBaseTypeIdV = staticBaseType->gen_typeid( context );
-        funcPtrV = virtual_field_addr_code_gen( context, scope, staticBaseType, staticBaseTypeIdV, fieldName );
+    bool staticLookup = nonvirtualLookup || staticBaseType->is_leaf_derivation();
+    if ( !staticLookup && staticBaseType->has_runtime_type_id() )
+        staticLookup = ( runtimeBaseTypeIdV == staticBaseType->gen_typeid( context ) );
+    if ( !staticLookup && staticBaseType->get_virtual_fields().has_field( fieldName ) )
+        staticLookup = ( staticBaseType->get_virtual_fields().get_field( fieldName )->get_decl_flags() & TXD_FINAL );
+
+    Value* funcPtrV = nullptr;
+    if ( staticLookup )
+        funcPtrV = static_method_code_gen( context, staticBaseType, fieldName );
+    if ( !funcPtrV ) {
+        if ( nonvirtualLookup ) {
+            Value* staticBaseTypeIdV = staticBaseType->gen_typeid( context );
+            funcPtrV = virtual_field_addr_code_gen( context, scope, staticBaseType, staticBaseTypeIdV, fieldName );
+        }
+        else {
+            context.gen_profile_dispatch_site( scope, origin, staticBaseType->get_declaration()->get_unique_full_name() + "." + fieldName );
+            funcPtrV = virtual_field_addr_code_gen( context, scope, staticBaseType, runtimeBaseTypeIdV, fieldName );
+        }
     }
-    else
-        funcPtrV = virtual_field_addr_code_gen( context, scope, staticBaseType, runtimeBaseTypeIdV, fieldName );
     // cast pointer type (necessary for certain (e.g. Ref-binding) specializations' methods):
     funcPtrV = scope->builder->CreatePointerCast( funcPtrV, lambdaT->getElementType( 0 ) );
     ASSERT( funcPtrV->getType()->getPointerElementType()->isFunctionTy(),
@@ -130,7 +175,7 @@ Value* TxFieldValueNode::code_gen_dyn_value( LlvmGenerationContext& context, Gen
             bool nonvirtualLookup = is_non_virtual_lookup( baseExpr );  // true for super.foo lookups
             Value* runtimeBaseTypeIdV = baseExpr->code_gen_typeid( context, scope );  // (static unless reference)
             Value* basePtrV = baseExpr->code_gen_dyn_address( context, scope );  // expected to be of pointer type
-            return instance_method_value_code_gen( context, scope, baseExpr->qualtype()->type()->acttype(), runtimeBaseTypeIdV, basePtrV,
+            return instance_method_value_code_gen( context, scope, this, baseExpr->qualtype()->type()->acttype(), runtimeBaseTypeIdV, basePtrV,
                                                    this->field->qualtype()->type()->acttype(), this->field->get_unique_name(),
                                                    nonvirtualLookup );
         }
@@ -140,7 +185,21 @@ Value* TxFieldValueNode::code_gen_dyn_value( LlvmGenerationContext& context, Gen
     }
 
     Value* valuePtr = this->code_gen_dyn_address( context, scope );
-    return scope->builder->CreateLoad( valuePtr );
+    if ( this->field->get_storage() == TXS_GLOBAL || this->field->get_storage() == TXS_STATIC ) {
+        // an unmodifiable global function is read from its initializer, so that invocations of it are direct calls:
+        if ( auto globalV = dyn_cast<GlobalVariable>( valuePtr ) ) {
+            if ( globalV->isConstant() && globalV->hasInitializer() && !this->field->qualtype()->is_modifiable()
+                    && this->field->qualtype()->get_type_class() == TXTC_FUNCTION )
+                return globalV->getInitializer();
+        }
+    }
+    return LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( valuePtr ), this->get_tbaa_tag( context ) );
+}
+
+MDNode* TxFieldValueNode::get_tbaa_tag( LlvmGenerationContext& context ) const {
+    if ( this->field->get_storage() == TXS_INSTANCE && this->baseExpr->qualtype()->get_type_class() == TXTC_ARRAY )
+        return context.get_tbaa_array_header_tag( this->field->get_unique_name() == "C" ? 0 : 1 );
+    return context.get_tbaa_tag( this->qualtype()->type()->acttype() );
 }
 
 Constant* TxFieldValueNode::code_gen_const_address( LlvmGenerationContext& context ) const {
@@ -159,7 +218,10 @@ Constant* TxFieldValueNode::code_gen_const_address( LlvmGenerationContext& conte
 Constant* TxFieldValueNode::code_gen_const_value( LlvmGenerationContext& context ) const {
     TRACE_CODEGEN( this, context );
 
-    if ( this->field->get_declaration()->get_definer()->get_init_expression() ) {
+    if ( auto evalValueC = get_const_eval_value( this->field ) ) {
+        return evalValueC;  // local field or argument of a function being evaluated at compile time
+    }
+    else if ( this->field->get_declaration()->get_definer()->get_init_expression() ) {
         return static_cast<TxFieldDefNode*>( this->field->get_declaration()->get_definer() )->code_gen_const_init_value( context );
     }
     else if ( this->field->get_storage() == TXS_INSTANCE ) {
@@ -179,3 +241,7 @@ Value* TxFieldAssigneeNode::code_gen_address( LlvmGenerationContext& context, Ge
     TRACE_CODEGEN( this, context );
     return this->field->code_gen_dyn_address( context, scope );
 }
+
+MDNode* TxFieldAssigneeNode::get_tbaa_tag( LlvmGenerationContext& context ) const {
+    return this->field->get_tbaa_tag( context );
+}
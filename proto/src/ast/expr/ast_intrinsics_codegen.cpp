@@ -33,6 +33,15 @@ Value* TxRefTypeIdNode::code_gen_dyn_address( LlvmGenerationContext& context, Ge
     TRACE_CODEGEN( this, context );
     auto refPtrV = this->refExpr->code_gen_addr( context, scope );
     auto refPtrT = cast<PointerType>( refPtrV->getType() );
+    if ( auto tidC = context.get_thin_ref_typeid( refPtrT->getPointerElementType() ) ) {
+        // thin references don't hold the type id, so it's stored in stack space
+        scope->use_alloca_insertion_point();
+        Value* tidPtrV = scope->builder->CreateAlloca( tidC->getType(), nullptr, "typeid" );
+        scope->use_current_insertion_point();
+
+        scope->builder->CreateStore( tidC, tidPtrV );
+        return tidPtrV;
+    }
     auto refMembPtrV = scope->builder->CreateStructGEP( refPtrT->getPointerElementType(), refPtrV, 1 );
     return refMembPtrV;
 }
@@ -69,6 +69,10 @@ void TxLambdaExprNode::code_gen_function_body( LlvmGenerationContext& context )
     BasicBlock *entryBlock = BasicBlock::Create( context.llvmContext, "entry", this->functionPtr );
     IRBuilder<> builder( entryBlock );
     GenScope fscope( &builder );
+    std::string debugName = ( this->fieldDefNode ? this->fieldDefNode->get_declaration()->get_unique_full_name()
+                                                 : this->functionPtr->getName().str() );
+    fscope.debugScope = context.gen_debug_subprogram( this, this->functionPtr, debugName );
+    context.gen_debug_location( &fscope, this );
 
     // name the concrete args (and self, if present) and allocate them on the stack:
     Function::arg_iterator fArgI = this->functionPtr->arg_begin();
@@ -91,12 +95,15 @@ void TxLambdaExprNode::code_gen_function_body( LlvmGenerationContext& context )
         }
     }
     fArgI++;
+    unsigned argNo = 1;
     for ( auto argDefI = this->funcHeaderNode->arguments->cbegin();
             argDefI != this->funcHeaderNode->arguments->cend();
-            fArgI++, argDefI++ )
+            fArgI++, argDefI++, argNo++ )
             {
         ( *argDefI )->typeExpression->code_gen_type( context );
-        gen_local_field( context, &fscope, ( *argDefI )->get_field(), &(*fArgI) );
+        auto argField = ( *argDefI )->get_field();
+        auto argA = gen_local_field( context, &fscope, argField, &(*fArgI) );
+        context.gen_debug_variable( &fscope, *argDefI, argField->get_unique_name(), argField->qualtype()->type()->acttype(), argA, argNo );
     }
 
     this->suite->code_gen( context, &fscope );
@@ -105,6 +112,8 @@ void TxLambdaExprNode::code_gen_function_body( LlvmGenerationContext& context )
         LOG_DEBUG( context.LOGGER(), "inserting default void return instruction for last block of function " << this->functionPtr->getName().str() );
         fscope.builder->CreateRetVoid();
     }
+
+    context.gen_profile_function( this->functionPtr, debugName );
     //ASSERT( entryBlock->getTerminator(), "Function entry block has no terminator" );
 }
 
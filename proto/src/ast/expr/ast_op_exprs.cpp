@@ -3,6 +3,7 @@
 #include "ast_conv.hpp"
 
 #include "symbol/type_registry.hpp"
+#include "symbol/type.hpp"
 #include "tx_error.hpp"
 #include "tx_lang_defs.hpp"
 
@@ -20,6 +21,61 @@ static inline void match_binary_operand_types( TxBinaryElemOperatorNode* binOpNo
     }
 }
 
+/** Defines the type of a binary operation where at least one operand is a Vec.
+ * The operation is applied lane-wise; a scalar operand is converted to the element type and applied to all lanes.
+ */
+static const TxQualType* define_vector_operation_type( TxBinaryElemOperatorNode* binOpNode, const TxType* ltype, const TxType* rtype ) {
+    auto vecNode = ( dynamic_cast<const TxVectorType*>( ltype->acttype() ) ? binOpNode->lhs : binOpNode->rhs );
+    auto vecType = static_cast<const TxVectorType*>( vecNode->originalExpr->qualtype()->type()->acttype() );
+    auto elemType = vecType->element_type()->type();
+
+    switch ( binOpNode->op_class ) {
+    case TXOC_ARITHMETIC:
+        if ( !elemType->is_scalar() )
+            CERR_THROWRES( binOpNode, "Vec operand of " << binOpNode->op << " doesn't have scalar elements: " << vecType );
+        break;
+    case TXOC_LOGICAL:
+        if ( !( is_concrete_sinteger_type( elemType->acttype() ) ||
+                is_concrete_uinteger_type( elemType->acttype() ) ||
+                elemType->get_runtime_type_id() == TXBT_BOOL ) )
+            CERR_THROWRES( binOpNode, "Vec operand of " << binOpNode->op << " doesn't have integer or boolean elements: " << vecType );
+        break;
+    case TXOC_SHIFT:
+        if ( !( is_concrete_sinteger_type( elemType->acttype() ) ||
+                is_concrete_uinteger_type( elemType->acttype() ) ) )
+            CERR_THROWRES( binOpNode, "Vec operand of " << binOpNode->op << " doesn't have integer elements: " << vecType );
+        if ( vecNode != binOpNode->lhs )
+            CERR_THROWRES( binOpNode, "Left operand of " << binOpNode->op << " is not a Vec: " << ltype );
+        break;
+    case TXOC_COMPARISON:
+        CERR_THROWRES( binOpNode, "Comparison operator " << binOpNode->op << " not applicable to Vec operands"
+                       " (the lanes_lt(), lanes_le(), etc methods produce lane-wise masks)" );
+    default:
+        THROW_LOGIC( "Invalid/unhandled op-class " << binOpNode->op_class << " in " << binOpNode );
+    }
+
+    auto vecTypeEnt = vecNode->originalExpr->qualtype()->type();
+    auto otherNode = ( vecNode == binOpNode->lhs ? binOpNode->rhs : binOpNode->lhs );
+    auto otherType = otherNode->originalExpr->qualtype()->type();
+    if ( dynamic_cast<const TxVectorType*>( otherType->acttype() ) ) {
+        if ( otherType != vecTypeEnt ) {
+            if ( auto_converts_to( otherNode->originalExpr, vecTypeEnt ) )
+                otherNode->insert_conversion( vecTypeEnt );
+            else
+                CERR_THROWRES( binOpNode, "Mismatching Vec operand types for binary operator " << binOpNode->op << ": " << ltype << ", " << rtype );
+        }
+    }
+    else if ( auto_converts_to( otherNode->originalExpr, elemType ) )
+        otherNode->insert_conversion( elemType );  // splatted to all lanes in code generation
+    else
+        CERR_THROWRES( binOpNode, "Operand of binary operator " << binOpNode->op << " doesn't match the Vec element type "
+                       << elemType << ": " << otherType );
+
+    binOpNode->lhs->resolve_type();
+    binOpNode->rhs->resolve_type();
+    return vecNode->qualtype();
+}
+
 const TxQualType* TxBinaryElemOperatorNode::define_type() {
     auto ltype = this->lhs->originalExpr->resolve_type()->type();
     auto rtype = this->rhs->originalExpr->resolve_type()->type();
@@ -29,6 +85,9 @@ const TxQualType* TxBinaryElemOperatorNode::define_type() {
     if ( rtype->get_type_class() != TXTC_ELEMENTARY )
         CERR_THROWRES( this, "Right operand of " << this->op << " is not an elementary type: " << rtype );
 
+    if ( dynamic_cast<const TxVectorType*>( ltype->acttype() ) || dynamic_cast<const TxVectorType*>( rtype->acttype() ) )
+        return define_vector_operation_type( this, ltype, rtype );
+
     switch ( this->op_class ) {
     case TXOC_ARITHMETIC:
     case TXOC_COMPARISON:
@@ -78,6 +137,11 @@ const TxQualType* TxBinaryElemOperatorNode::define_type() {
 
 const TxQualType* TxUnaryMinusNode::define_type() {
     auto opType = this->operand->originalExpr->resolve_type();
+    if ( auto vecType = dynamic_cast<const TxVectorType*>( opType->type()->acttype() ) ) {
+        if ( !vecType->element_type()->type()->is_scalar() )
+            CERR_THROWRES( this, "Vec operand for unary '-' doesn't have scalar elements: " << opType );
+        return opType;  // (no promotion of unsigned lanes)
+    }
     if ( !opType->type()->is_scalar() )
         CERR_THROWRES( this, "Operand for unary '-' is not of scalar type: " << opType );
     if ( dynamic_cast<TxIntegerLitNode*>( this->operand->originalExpr ) )
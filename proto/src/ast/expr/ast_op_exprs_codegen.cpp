@@ -1,6 +1,7 @@
 #include "ast_op_exprs.hpp"
 
 #include "ast_ref.hpp"
+#include "ast_vector.hpp"
 #include "ast/ast_fielddef_node.hpp"
 
 #include "tx_logging.hpp"
@@ -53,6 +54,13 @@ static unsigned get_llvm_op( TxOperationClass op_class, TxOperation op, const Tx
     return llvm_op;
 }
 
+/** If the result of the binary operation is a Vec, returns its element type, otherwise returns null. */
+static const TxActualType* vector_element_type( const TxBinaryElemOperatorNode* binOpNode ) {
+    if ( auto vecType = dynamic_cast<const TxVectorType*>( binOpNode->qualtype()->type()->acttype() ) )
+        return vecType->element_type()->type()->acttype();
+    return nullptr;
+}
+
 llvm::Constant* TxBinaryElemOperatorNode::code_gen_const_value( LlvmGenerationContext& context ) const {
     TRACE_CODEGEN( this, context );
     auto lval = this->lhs->code_gen_const_value( context );
@@ -60,6 +68,14 @@ llvm::Constant* TxBinaryElemOperatorNode::code_gen_const_value( LlvmGenerationCo
 
     auto op_class = get_op_class( this->op );
     auto computeType = ( op_class == TXOC_ARITHMETIC ? this->qualtype()->type()->acttype() : this->lhs->resolve_type()->type()->acttype() );
+    if ( auto elemType = vector_element_type( this ) ) {
+        // a scalar operand is applied to all lanes
+        computeType = elemType;
+        if ( !lval->getType()->isVectorTy() )
+            lval = ConstantVector::getSplat( rval->getType()->getVectorNumElements(), lval );
+        else if ( !rval->getType()->isVectorTy() )
+            rval = ConstantVector::getSplat( lval->getType()->getVectorNumElements(), rval );
+    }
     bool float_operation = false;
     unsigned llvm_op = get_llvm_op( op_class, this->op, computeType, &float_operation );
 
@@ -84,6 +100,14 @@ Value* TxBinaryElemOperatorNode::code_gen_dyn_value( LlvmGenerationContext& cont
 
     auto op_class = get_op_class( this->op );
     auto computeType = ( op_class == TXOC_ARITHMETIC ? this->qualtype()->type()->acttype() : this->lhs->resolve_type()->type()->acttype() );
+    if ( auto elemType = vector_element_type( this ) ) {
+        // a scalar operand is applied to all lanes
+        computeType = elemType;
+        if ( !lval->getType()->isVectorTy() )
+            lval = scope->builder->CreateVectorSplat( rval->getType()->getVectorNumElements(), lval );
+        else if ( !rval->getType()->isVectorTy() )
+            rval = scope->builder->CreateVectorSplat( lval->getType()->getVectorNumElements(), rval );
+    }
     bool float_operation = false;
     unsigned llvm_op = get_llvm_op( op_class, this->op, computeType, &float_operation );
 
@@ -114,6 +138,8 @@ llvm::Constant* TxUnaryMinusNode::code_gen_const_value( LlvmGenerationContext& c
         return operand;  // negation has been applied directly to the literal
     }
     const TxActualType* opType = this->qualtype()->type()->acttype();
+    if ( auto vecType = dynamic_cast<const TxVectorType*>( opType ) )
+        opType = vecType->element_type()->type()->acttype();  // negates all lanes
     if ( dynamic_cast<const TxIntegerType*>( opType ) ) {
         return ConstantExpr::getNeg( operand  );
     }
@@ -130,6 +156,8 @@ Value* TxUnaryMinusNode::code_gen_dyn_value( LlvmGenerationContext& context, Gen
         return operand;  // negation has been applied directly to the literal
     }
     const TxActualType* opType = this->qualtype()->type()->acttype();
+    if ( auto vecType = dynamic_cast<const TxVectorType*>( opType ) )
+        opType = vecType->element_type()->type()->acttype();  // negates all lanes
     if ( dynamic_cast<const TxIntegerType*>( opType ) ) {
         return scope->builder->CreateNeg( operand );
     }
@@ -161,7 +189,14 @@ llvm::Constant* TxEqualityOperatorNode::code_gen_const_value( LlvmGenerationCont
     auto lhsTypeclass = lhsType->get_type_class();
 
     if ( lhsTypeclass == TXTC_ELEMENTARY ) {
-        if ( dynamic_cast<const TxFloatingType*>( lhsType ) ) {
+        if ( lvalC->getType()->isVectorTy() ) {
+            // vectors are equal if all their lanes are equal
+            auto lanesEqC = ( lvalC->getType()->getVectorElementType()->isFloatingPointTy()
+                    ? ConstantExpr::getFCmp( CmpInst::Predicate::FCMP_OEQ, lvalC, rvalC )
+                    : ConstantExpr::getICmp( CmpInst::Predicate::ICMP_EQ, lvalC, rvalC ) );
+            return gen_vector_all_lanes( context, lanesEqC );
+        }
+        else if ( dynamic_cast<const TxFloatingType*>( lhsType ) ) {
             return ConstantExpr::getFCmp( CmpInst::Predicate::FCMP_OEQ, lvalC, rvalC );
         }
         else {  // integer or boolean
@@ -220,7 +255,14 @@ Value* TxEqualityOperatorNode::code_gen_dyn_value( LlvmGenerationContext& contex
     if ( lhsTypeclass == TXTC_ELEMENTARY ) {
         auto lval = this->lhs->code_gen_dyn_value( context, scope );
         auto rval = this->rhs->code_gen_dyn_value( context, scope );
-        if ( dynamic_cast<const TxFloatingType*>( lhsType ) ) {
+        if ( lval->getType()->isVectorTy() ) {
+            // vectors are equal if all their lanes are equal
+            auto lanesEqV = ( lval->getType()->getVectorElementType()->isFloatingPointTy()
+                    ? scope->builder->CreateFCmp( CmpInst::Predicate::FCMP_OEQ, lval, rval )
+                    : scope->builder->CreateICmp( CmpInst::Predicate::ICMP_EQ, lval, rval ) );
+            return gen_vector_all_lanes( context, scope, lanesEqV );
+        }
+        else if ( dynamic_cast<const TxFloatingType*>( lhsType ) ) {
             return scope->builder->CreateFCmp( CmpInst::Predicate::FCMP_OEQ, lval, rval, fieldName );
         }
         else {  // integer or boolean
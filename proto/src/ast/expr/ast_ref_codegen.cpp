@@ -14,6 +14,18 @@ Value* gen_get_struct_member( LlvmGenerationContext& context, GenScope* scope, V
     }
     else {  // direct / "register" struct
         ASSERT( structV->getType()->isStructTy(), "expected value to be a struct: " << structV );
+        // look through the insertions that constructed the struct value, so that statically known members
+        // (e.g. the function of a lambda object) remain known:
+        while ( auto insertV = dyn_cast<InsertValueInst>( structV ) ) {
+            if ( *insertV->idx_begin() == ix ) {
+                if ( insertV->getNumIndices() == 1 )
+                    return insertV->getInsertedValueOperand();
+                break;  // (member is partially overwritten)
+            }
+            structV = insertV->getAggregateOperand();
+        }
+        if ( auto structC = dyn_cast<Constant>( structV ) )
+            return structC->getAggregateElement( ix );
         return scope->builder->CreateExtractValue( structV, ix );
     }
 }
@@ -35,7 +47,11 @@ Value* gen_get_ref_pointer( LlvmGenerationContext& context, GenScope* scope, Val
 }
 
 Value* gen_get_ref_typeid( LlvmGenerationContext& context, GenScope* scope, Value* refV ) {
+    if ( auto tidC = context.get_thin_ref_typeid( refV->getType() ) )
+        return tidC;
     if ( refV->getType()->isPointerTy() ) {  // address of struct
+        if ( auto tidC = context.get_thin_ref_typeid( refV->getType()->getPointerElementType() ) )
+            return tidC;
         std::cerr << "DOES THIS HAPPEN? gen_get_ref_typeid() on address of ref struct: " << refV << std::endl;
         auto refPtrA = scope->builder->CreateStructGEP( refV->getType()->getPointerElementType(), refV, 1 );
         return scope->builder->CreateLoad( refPtrA, "tid" );
@@ -49,7 +65,8 @@ Value* gen_ref( LlvmGenerationContext& context, GenScope* scope, Type* refT, Val
     Value* refV = UndefValue::get( refT );
     auto castPtrV = scope->builder->CreatePointerCast( ptrV, refT->getStructElementType( 0 ) );
     refV = scope->builder->CreateInsertValue( refV, castPtrV, 0 );
-    refV = scope->builder->CreateInsertValue( refV, tidV, 1 );
+    if ( !context.get_thin_ref_typeid( refT ) )  // (thin references don't hold the type id)
+        refV = scope->builder->CreateInsertValue( refV, tidV, 1 );
     return refV;
 }
 
@@ -59,10 +76,14 @@ Constant* gen_get_ref_pointer( LlvmGenerationContext& context, Constant* refC )
 }
 
 Constant* gen_get_ref_typeid( LlvmGenerationContext& context, Constant* refC ) {
+    if ( auto tidC = context.get_thin_ref_typeid( refC->getType() ) )
+        return tidC;
     return refC->getAggregateElement( 1 );
 }
 
 Constant* gen_ref( LlvmGenerationContext& context, Type* refT, Constant* ptrC, Constant* tidC ) {
+    if ( context.get_thin_ref_typeid( refT ) )
+        return ConstantStruct::get( cast<StructType>(refT), { ConstantExpr::getPointerCast( ptrC, refT->getStructElementType( 0 ) ) } );
     return ConstantStruct::get( cast<StructType>(refT), { ConstantExpr::getPointerCast( ptrC, refT->getStructElementType( 0 ) ), tidC } );
 }
 
@@ -134,7 +155,7 @@ Value* TxReferenceDerefNode::code_gen_dyn_address( LlvmGenerationContext& contex
 
 Value* TxReferenceDerefNode::code_gen_dyn_value( LlvmGenerationContext& context, GenScope* scope ) const {
     Value* ptrV = this->code_gen_dyn_address( context, scope );
-    return scope->builder->CreateLoad( ptrV );
+    return LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( ptrV ), context.get_tbaa_tag( this->qualtype()->type()->acttype() ) );
 }
 
 Value* TxReferenceDerefNode::code_gen_typeid( LlvmGenerationContext& context, GenScope* scope ) const {
@@ -0,0 +1,90 @@
+#include "ast_vector.hpp"
+
+#include "ast_field.hpp"
+
+#include "ast/ast_declpass.hpp"
+#include "ast/type/ast_types.hpp"
+
+#include "ast/stmt/ast_panicstmt_node.hpp"
+
+#include "symbol/type.hpp"
+#include "tx_error.hpp"
+
+TxVectorIntrinsicNode::TxVectorIntrinsicNode( const TxLocation& ploc, TxVectorOp op, std::vector<TxExpressionNode*>* operands )
+        : TxExpressionNode( ploc ), op( op ), operands( operands ) {
+    ASSERT( !operands->empty(), "Vector intrinsic without operands in " << this );
+    if ( op >= TXVOP_EQ && op <= TXVOP_GE ) {
+        // the comparisons produce a Vec<Bool,N> mask with the same lane count as the operands
+        this->maskTypeNode = new TxGenSpecTypeNode(
+                ploc, new TxNamedTypeNode( ploc, "tx.Vec" ),
+                new std::vector<TxTypeArgumentNode*>( { new TxTypeTypeArgumentNode( new TxNamedTypeNode( ploc, "tx.Bool" ) ),
+                                                        new TxValueTypeArgumentNode( new TxFieldValueNode( ploc, nullptr, "N" ) ) } ) );
+    }
+}
+
+const TxQualType* TxVectorIntrinsicNode::define_type() {
+    auto vecQType = this->operands->at( 0 )->resolve_type();
+    auto vecType = dynamic_cast<const TxVectorType*>( vecQType->type()->acttype() );
+    if ( !vecType )
+        CERR_THROWRES( this->operands->at( 0 ), "Operand of vector intrinsic is not a Vec: " << vecQType );
+
+    switch ( this->op ) {
+    case TXVOP_LANES:
+        return new TxQualType( this->registry().get_builtin_type( TXBT_UINT ) );
+
+    case TXVOP_EXTRACT:
+    case TXVOP_REDUCE_ADD:
+    case TXVOP_REDUCE_MUL:
+    case TXVOP_REDUCE_MIN:
+    case TXVOP_REDUCE_MAX:
+    case TXVOP_REDUCE_AND:
+    case TXVOP_REDUCE_OR:
+    case TXVOP_REDUCE_XOR:
+        return vecType->element_type();
+
+    case TXVOP_EQ:
+    case TXVOP_NE:
+    case TXVOP_LT:
+    case TXVOP_LE:
+    case TXVOP_GT:
+    case TXVOP_GE:
+        return this->maskTypeNode->resolve_type();
+
+    case TXVOP_ANY:
+    case TXVOP_ALL:
+        return new TxQualType( this->registry().get_builtin_type( TXBT_BOOL ) );
+
+    default:
+        return new TxQualType( vecQType->type() );
+    }
+}
+
+void TxVectorIntrinsicNode::symbol_resolution_pass() {
+    TxExpressionNode::symbol_resolution_pass();
+    if ( this->maskTypeNode )
+        this->maskTypeNode->symbol_resolution_pass();
+    for ( auto operand : *this->operands )
+        operand->symbol_resolution_pass();
+
+    if ( this->op == TXVOP_LOAD || this->op == TXVOP_EXTRACT || this->op == TXVOP_INSERT ) {
+        this->panicNode = new TxPanicStmtNode( this->ploc, ( this->op == TXVOP_LOAD ? "Vec load out of bounds"
+                                                                                     : "Vec lane index out of bounds" ) );
+        run_declaration_pass( panicNode, this, "panic" );
+        panicNode->symbol_resolution_pass();
+    }
+}
+
+
+TxVectorStoreStmtNode::TxVectorStoreStmtNode( const TxLocation& ploc, TxExpressionNode* vec, TxExpressionNode* dst, TxExpressionNode* ix )
+        : TxStatementNode( ploc ), vec( vec ), dst( dst ), ix( ix ) {
+    this->panicNode = new TxPanicStmtNode( ploc, "Vec store out of bounds" );
+}
+
+void TxVectorStoreStmtNode::symbol_resolution_pass() {
+    this->vec->symbol_resolution_pass();
+    this->dst->symbol_resolution_pass();
+    this->ix->symbol_resolution_pass();
+    if ( this->dst->qualtype()->get_type_class() != TXTC_ARRAY )
+        CERROR( this->dst, "Operand is not an array: " << this->dst->qualtype() );
+    this->panicNode->symbol_resolution_pass();
+}
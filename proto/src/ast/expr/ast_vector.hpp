@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ast_expr_node.hpp"
+#include "ast/type/ast_typeexpr_node.hpp"
+#include "ast/stmt/ast_stmt_node.hpp"
+#include "ast/ast_util.hpp"
+
+#include "symbol/qual_type.hpp"
+#include "symbol/type_registry.hpp"
+
+/** The intrinsic operations of the built-in SIMD vector type Vec<E,N>. */
+enum TxVectorOp {
+    TXVOP_ZERO,        // all lanes zero
+    TXVOP_SPLAT,       // all lanes set to a value
+    TXVOP_LOAD,        // lanes loaded from consecutive array elements
+    TXVOP_LANES,       // the lane count
+    TXVOP_EXTRACT,     // the value of a lane
+    TXVOP_INSERT,      // copy with the value of a lane replaced
+    TXVOP_SHUFFLE,     // lanes permuted by a vector of lane indices
+    TXVOP_REVERSE,     // lanes in reverse order
+    TXVOP_REDUCE_ADD,  // horizontal reductions across the lanes:
+    TXVOP_REDUCE_MUL,
+    TXVOP_REDUCE_MIN,
+    TXVOP_REDUCE_MAX,
+    TXVOP_REDUCE_AND,
+    TXVOP_REDUCE_OR,
+    TXVOP_REDUCE_XOR,
+    TXVOP_MIN,         // lane-wise minimum and maximum
+    TXVOP_MAX,
+    TXVOP_EQ,          // lane-wise comparisons, producing a Vec<Bool,N> mask:
+    TXVOP_NE,
+    TXVOP_LT,
+    TXVOP_LE,
+    TXVOP_GT,
+    TXVOP_GE,
+    TXVOP_SELECT,      // lane-wise choice by a mask
+    TXVOP_ANY,         // whether any / all lanes of a Bool vector are TRUE
+    TXVOP_ALL,
+};
+
+/** Returns the LLVM i1 value that is true if all lanes of the specified Bool vector value are true. */
+llvm::Value* gen_vector_all_lanes( LlvmGenerationContext& context, GenScope* scope, llvm::Value* maskV );
+
+/** Returns the LLVM i1 constant that is true if all lanes of the specified Bool vector constant are true. */
+llvm::Constant* gen_vector_all_lanes( LlvmGenerationContext& context, llvm::Constant* maskC );
+
+
+/** Intrinsic operation on Vec<E,N> values, used to implement the built-in Vec methods.
+ * The first operand is always the vector operated on (for the constructing operations - ZERO, SPLAT, LOAD -
+ * it is the object being constructed, which is not evaluated). The remaining operands are:
+ *     SPLAT:    value
+ *     LOAD:     array, index
+ *     EXTRACT:  lane
+ *     INSERT:   lane, value
+ *     SHUFFLE:  lane indices vector
+ *     MIN, MAX, and the comparisons:  other vector
+ *     SELECT:   mask, other vector (lanes where the mask is TRUE are taken from the first operand)
+ * LOAD, EXTRACT and INSERT are bounds checked.
+ */
+class TxVectorIntrinsicNode : public TxExpressionNode {
+    TxTypeExpressionNode* maskTypeNode = nullptr;
+    class TxStatementNode* panicNode = nullptr;
+
+protected:
+    virtual const TxQualType* define_type() override;
+
+public:
+    const TxVectorOp op;
+    std::vector<TxExpressionNode*>* operands;
+
+    TxVectorIntrinsicNode( const TxLocation& ploc, TxVectorOp op, std::vector<TxExpressionNode*>* operands );
+
+    virtual TxVectorIntrinsicNode* make_ast_copy() const override {
+        return new TxVectorIntrinsicNode( this->ploc, this->op, make_node_vec_copy( this->operands ) );
+    }
+
+    virtual void symbol_resolution_pass() override;
+
+    virtual llvm::Value* code_gen_dyn_value( LlvmGenerationContext& context, GenScope* scope ) const override;
+
+    virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
+        if ( this->maskTypeNode )
+            this->maskTypeNode->visit_ast( visitor, thisCursor, "masktype", context );
+        for ( auto operand : *this->operands )
+            operand->visit_ast( visitor, thisCursor, "operand", context );
+    }
+};
+
+/** Intrinsic store of a vector's lanes into consecutive array elements, used to implement Vec.store():
+ * Sets dst[ix] ... dst[ix+N-1] to the lanes, and extends dst.L if the range ends past it.
+ * The bounds are checked once for the whole range.
+ */
+class TxVectorStoreStmtNode : public TxStatementNode {
+    class TxStatementNode* panicNode;
+
+public:
+    TxExpressionNode* vec;
+    TxExpressionNode* dst;
+    TxExpressionNode* ix;
+
+    TxVectorStoreStmtNode( const TxLocation& ploc, TxExpressionNode* vec, TxExpressionNode* dst, TxExpressionNode* ix );
+
+    virtual TxVectorStoreStmtNode* make_ast_copy() const override {
+        return new TxVectorStoreStmtNode( this->ploc, this->vec->make_ast_copy(), this->dst->make_ast_copy(), this->ix->make_ast_copy() );
+    }
+
+    virtual void symbol_resolution_pass() override;
+
+    virtual void code_gen( LlvmGenerationContext& context, GenScope* scope ) const override;
+
+    virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
+        this->vec->visit_ast( visitor, thisCursor, "vec", context );
+        this->dst->visit_ast( visitor, thisCursor, "dst", context );
+        this->ix->visit_ast( visitor, thisCursor, "ix", context );
+        this->panicNode->visit_ast( visitor, thisCursor, "panic", context );
+    }
+};
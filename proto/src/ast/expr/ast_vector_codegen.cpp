@@ -0,0 +1,317 @@
+#include "ast_vector.hpp"
+
+#include "symbol/type.hpp"
+#include "tx_error.hpp"
+
+#include "llvm_generator.hpp"
+
+using namespace llvm;
+
+
+static const TxVectorType* vector_type( const TxExpressionNode* vecExpr ) {
+    return static_cast<const TxVectorType*>( vecExpr->qualtype()->type()->acttype() );
+}
+
+/** Returns the lane count of the vector type, which must be statically known in order to generate its code. */
+static uint32_t get_lanes( const TxNode* origin, const TxVectorType* vecType ) {
+    auto lanes = vecType->lanes();
+    if ( !lanes )
+        CERR_CODECHECK( origin, "Vec lane count is not statically known: " << vecType );
+    return lanes;
+}
+
+/** Generates a branch to the panic statement, taken if condV is true. */
+static void gen_panic_if( LlvmGenerationContext& context, GenScope* scope, Value* condV, const TxStatementNode* panicNode ) {
+    auto parentFunc = scope->builder->GetInsertBlock()->getParent();
+    BasicBlock* trueBlock = BasicBlock::Create( context.llvmContext, "if_true", parentFunc );
+    BasicBlock* nextBlock = BasicBlock::Create( context.llvmContext, "if_next", parentFunc );
+    scope->builder->CreateCondBr( condV, trueBlock, nextBlock, context.get_panic_branch_weights() );
+
+    scope->builder->SetInsertPoint( trueBlock );
+    panicNode->code_gen( context, scope );
+    scope->builder->CreateBr( nextBlock );  // terminate block, though won't be executed
+
+    scope->builder->SetInsertPoint( nextBlock );
+}
+
+/** Returns a pointer to the array's element at the given index (without bounds checking). */
+static Value* gen_array_elem_ptr( LlvmGenerationContext& context, GenScope* scope, Value* arrayPtrV, Value* ixV ) {
+    Value* ixs[] = { ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ),
+                     ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 2 ),
+                     ixV };
+    return scope->builder->CreateInBoundsGEP( arrayPtrV, ixs );
+}
+
+/** Loads a vector from consecutive array elements starting at elemPtrV.
+ * This is a single (element aligned) vector load, except for Bool vectors whose lanes are bits while the array elements are bytes. */
+static Value* gen_vector_load( GenScope* scope, VectorType* vecT, Value* elemPtrV ) {
+    auto elemT = vecT->getElementType();
+    if ( elemT->isIntegerTy( 1 ) ) {
+        Value* vecV = UndefValue::get( vecT );
+        for ( unsigned i = 0; i < vecT->getNumElements(); i++ ) {
+            auto laneV = scope->builder->CreateLoad( scope->builder->CreateConstInBoundsGEP1_32( elemT, elemPtrV, i ) );
+            vecV = scope->builder->CreateInsertElement( vecV, laneV, scope->builder->getInt32( i ) );
+        }
+        return vecV;
+    }
+    auto vecPtrV = scope->builder->CreatePointerCast( elemPtrV, vecT->getPointerTo() );
+    return scope->builder->CreateAlignedLoad( vecPtrV, elemT->getPrimitiveSizeInBits() / 8 );
+}
+
+/** Stores a vector into consecutive array elements starting at elemPtrV (see gen_vector_load()). */
+static void gen_vector_store( GenScope* scope, Value* vecV, Value* elemPtrV ) {
+    auto vecT = cast<VectorType>( vecV->getType() );
+    auto elemT = vecT->getElementType();
+    if ( elemT->isIntegerTy( 1 ) ) {
+        for ( unsigned i = 0; i < vecT->getNumElements(); i++ ) {
+            auto laneV = scope->builder->CreateExtractElement( vecV, scope->builder->getInt32( i ) );
+            scope->builder->CreateStore( laneV, scope->builder->CreateConstInBoundsGEP1_32( elemT, elemPtrV, i ) );
+        }
+        return;
+    }
+    auto vecPtrV = scope->builder->CreatePointerCast( elemPtrV, vecT->getPointerTo() );
+    scope->builder->CreateAlignedStore( vecV, vecPtrV, elemT->getPrimitiveSizeInBits() / 8 );
+}
+
+/** Returns the lane-wise minimum (or maximum) of two vectors. */
+static Value* gen_min_max( GenScope* scope, Value* lhsV, Value* rhsV, bool isFloat, bool isSigned, bool max ) {
+    Value* condV;
+    if ( isFloat )
+        condV = ( max ? scope->builder->CreateFCmpOGT( lhsV, rhsV ) : scope->builder->CreateFCmpOLT( lhsV, rhsV ) );
+    else if ( isSigned )
+        condV = ( max ? scope->builder->CreateICmpSGT( lhsV, rhsV ) : scope->builder->CreateICmpSLT( lhsV, rhsV ) );
+    else
+        condV = ( max ? scope->builder->CreateICmpUGT( lhsV, rhsV ) : scope->builder->CreateICmpULT( lhsV, rhsV ) );
+    return scope->builder->CreateSelect( condV, lhsV, rhsV );
+}
+
+/** Returns the lane-wise result of a bitwise operation, which for floating-point lanes operates on their bit patterns. */
+static Value* gen_bitwise( GenScope* scope, Instruction::BinaryOps op, Value* lhsV, Value* rhsV ) {
+    auto vecT = cast<VectorType>( lhsV->getType() );
+    if ( vecT->getElementType()->isFloatingPointTy() ) {
+        auto intVecT = VectorType::getInteger( vecT );
+        auto resultV = scope->builder->CreateBinOp( op, scope->builder->CreateBitCast( lhsV, intVecT ),
+                                                    scope->builder->CreateBitCast( rhsV, intVecT ) );
+        return scope->builder->CreateBitCast( resultV, vecT );
+    }
+    return scope->builder->CreateBinOp( op, lhsV, rhsV );
+}
+
+/** Reduces the lanes of a vector to a single value, by combining the upper and lower halves of the vector
+ * until one lane remains (which maps to the targets' horizontal SIMD operations).
+ * Note that for floating-point addition and multiplication the rounding may thus differ from a sequential loop. */
+static Value* gen_reduction( LlvmGenerationContext& context, GenScope* scope, Value* vecV, TxVectorOp op, bool isFloat, bool isSigned ) {
+    auto i32T = Type::getInt32Ty( context.llvmContext );
+    auto vecT = cast<VectorType>( vecV->getType() );
+    auto lanes = vecT->getNumElements();
+    for ( unsigned width = lanes / 2; width >= 1; width /= 2 ) {
+        std::vector<Constant*> maskCs;
+        for ( unsigned i = 0; i < lanes; i++ )
+            maskCs.push_back( i < width ? static_cast<Constant*>( ConstantInt::get( i32T, i + width ) ) : UndefValue::get( i32T ) );
+        auto upperV = scope->builder->CreateShuffleVector( vecV, UndefValue::get( vecT ), ConstantVector::get( maskCs ) );
+        switch ( op ) {
+        case TXVOP_REDUCE_ADD:
+            vecV = ( isFloat ? scope->builder->CreateFAdd( vecV, upperV ) : scope->builder->CreateAdd( vecV, upperV ) );
+            break;
+        case TXVOP_REDUCE_MUL:
+            vecV = ( isFloat ? scope->builder->CreateFMul( vecV, upperV ) : scope->builder->CreateMul( vecV, upperV ) );
+            break;
+        case TXVOP_REDUCE_MIN:
+            vecV = gen_min_max( scope, vecV, upperV, isFloat, isSigned, false );
+            break;
+        case TXVOP_REDUCE_MAX:
+            vecV = gen_min_max( scope, vecV, upperV, isFloat, isSigned, true );
+            break;
+        case TXVOP_REDUCE_AND:
+            vecV = gen_bitwise( scope, Instruction::And, vecV, upperV );
+            break;
+        case TXVOP_REDUCE_OR:
+            vecV = gen_bitwise( scope, Instruction::Or, vecV, upperV );
+            break;
+        case TXVOP_REDUCE_XOR:
+            vecV = gen_bitwise( scope, Instruction::Xor, vecV, upperV );
+            break;
+        default:
+            THROW_LOGIC( "Not a vector reduction operation: " << op );
+        }
+    }
+    return scope->builder->CreateExtractElement( vecV, ConstantInt::get( i32T, 0 ) );
+}
+
+/** Returns the Bool vector that is TRUE in the lanes that are nonzero. */
+static Value* gen_nonzero_lanes( GenScope* scope, Value* vecV ) {
+    if ( vecV->getType()->getVectorElementType()->isIntegerTy( 1 ) )
+        return vecV;
+    auto zeroV = Constant::getNullValue( vecV->getType() );
+    if ( vecV->getType()->getVectorElementType()->isFloatingPointTy() )
+        return scope->builder->CreateFCmpUNE( vecV, zeroV );
+    return scope->builder->CreateICmpNE( vecV, zeroV );
+}
+
+/** Returns the lanes of a Bool vector as the bits of an integer. */
+static Value* gen_lane_bits( LlvmGenerationContext& context, GenScope* scope, Value* maskV ) {
+    auto lanes = maskV->getType()->getVectorNumElements();
+    return scope->builder->CreateBitCast( maskV, IntegerType::get( context.llvmContext, lanes ) );
+}
+
+Value* gen_vector_all_lanes( LlvmGenerationContext& context, GenScope* scope, Value* maskV ) {
+    auto bitsV = gen_lane_bits( context, scope, maskV );
+    return scope->builder->CreateICmpEQ( bitsV, Constant::getAllOnesValue( bitsV->getType() ) );
+}
+
+Constant* gen_vector_all_lanes( LlvmGenerationContext& context, Constant* maskC ) {
+    auto lanes = maskC->getType()->getVectorNumElements();
+    auto bitsC = ConstantExpr::getBitCast( maskC, IntegerType::get( context.llvmContext, lanes ) );
+    return ConstantExpr::getICmp( CmpInst::ICMP_EQ, bitsC, Constant::getAllOnesValue( bitsC->getType() ) );
+}
+
+
+Value* TxVectorIntrinsicNode::code_gen_dyn_value( LlvmGenerationContext& context, GenScope* scope ) const {
+    TRACE_CODEGEN( this, context );
+    auto i32T = Type::getInt32Ty( context.llvmContext );
+    auto i64T = Type::getInt64Ty( context.llvmContext );
+    auto vecType = vector_type( this->operands->at( 0 ) );
+    auto lanes = get_lanes( this, vecType );
+    auto vecT = cast<VectorType>( context.get_llvm_type( vecType ) );
+    auto elemType = vecType->element_type()->type()->acttype();
+    bool isFloat = dynamic_cast<const TxFloatingType*>( elemType );
+    bool isSigned = false;
+    if ( auto intType = dynamic_cast<const TxIntegerType*>( elemType ) )
+        isSigned = intType->is_signed();
+
+    // the constructing operations don't evaluate the vector operand:
+    switch ( this->op ) {
+    case TXVOP_ZERO:
+        return Constant::getNullValue( vecT );
+
+    case TXVOP_SPLAT:
+        return scope->builder->CreateVectorSplat( lanes, this->operands->at( 1 )->code_gen_expr( context, scope ) );
+
+    case TXVOP_LOAD: {
+        auto arrayPtrV = this->operands->at( 1 )->code_gen_addr( context, scope );
+        auto ixV = this->operands->at( 2 )->code_gen_expr( context, scope );
+        auto lenPtrV = scope->builder->CreateStructGEP( arrayPtrV->getType()->getPointerElementType(), arrayPtrV, 1 );
+        auto lenV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( lenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
+        // (the range end is computed in 64 bits so that overflow can't bypass the check)
+        auto end64V = scope->builder->CreateAdd( scope->builder->CreateZExt( ixV, i64T ), ConstantInt::get( i64T, lanes ) );
+        gen_panic_if( context, scope, scope->builder->CreateICmpUGT( end64V, scope->builder->CreateZExt( lenV, i64T ) ),
+                      this->panicNode );
+        return gen_vector_load( scope, vecT, gen_array_elem_ptr( context, scope, arrayPtrV, ixV ) );
+    }
+
+    case TXVOP_LANES:
+        return ConstantInt::get( i32T, lanes );
+
+    default:
+        break;
+    }
+
+    auto vecV = this->operands->at( 0 )->code_gen_expr( context, scope );
+    switch ( this->op ) {
+    case TXVOP_EXTRACT:
+    case TXVOP_INSERT: {
+        auto laneV = this->operands->at( 1 )->code_gen_expr( context, scope );
+        gen_panic_if( context, scope, scope->builder->CreateICmpUGE( laneV, ConstantInt::get( laneV->getType(), lanes ) ),
+                      this->panicNode );
+        if ( this->op == TXVOP_EXTRACT )
+            return scope->builder->CreateExtractElement( vecV, laneV );
+        return scope->builder->CreateInsertElement( vecV, this->operands->at( 2 )->code_gen_expr( context, scope ), laneV );
+    }
+
+    case TXVOP_SHUFFLE: {
+        // the lane indices are dynamic, and taken modulo the lane count
+        auto indicesV = this->operands->at( 1 )->code_gen_expr( context, scope );
+        auto ixMaskV = ConstantInt::get( indicesV->getType()->getVectorElementType(), lanes - 1 );
+        Value* resultV = UndefValue::get( vecT );
+        for ( unsigned i = 0; i < lanes; i++ ) {
+            auto ixV = scope->builder->CreateAnd( scope->builder->CreateExtractElement( indicesV, ConstantInt::get( i32T, i ) ), ixMaskV );
+            resultV = scope->builder->CreateInsertElement( resultV, scope->builder->CreateExtractElement( vecV, ixV ),
+                                                           ConstantInt::get( i32T, i ) );
+        }
+        return resultV;
+    }
+
+    case TXVOP_REVERSE: {
+        std::vector<Constant*> maskCs;
+        for ( unsigned i = 0; i < lanes; i++ )
+            maskCs.push_back( ConstantInt::get( i32T, lanes - 1 - i ) );
+        return scope->builder->CreateShuffleVector( vecV, UndefValue::get( vecT ), ConstantVector::get( maskCs ) );
+    }
+
+    case TXVOP_REDUCE_ADD:
+    case TXVOP_REDUCE_MUL:
+    case TXVOP_REDUCE_MIN:
+    case TXVOP_REDUCE_MAX:
+    case TXVOP_REDUCE_AND:
+    case TXVOP_REDUCE_OR:
+    case TXVOP_REDUCE_XOR:
+        return gen_reduction( context, scope, vecV, this->op, isFloat, isSigned );
+
+    case TXVOP_MIN:
+    case TXVOP_MAX:
+        return gen_min_max( scope, vecV, this->operands->at( 1 )->code_gen_expr( context, scope ), isFloat, isSigned,
+                            this->op == TXVOP_MAX );
+
+    case TXVOP_EQ:
+    case TXVOP_NE:
+    case TXVOP_LT:
+    case TXVOP_LE:
+    case TXVOP_GT:
+    case TXVOP_GE: {
+        static const CmpInst::Predicate FLOAT_PREDS[] = { CmpInst::FCMP_OEQ, CmpInst::FCMP_UNE, CmpInst::FCMP_OLT,
+                                                          CmpInst::FCMP_OLE, CmpInst::FCMP_OGT, CmpInst::FCMP_OGE };
+        static const CmpInst::Predicate SINT_PREDS[] = { CmpInst::ICMP_EQ, CmpInst::ICMP_NE, CmpInst::ICMP_SLT,
+                                                         CmpInst::ICMP_SLE, CmpInst::ICMP_SGT, CmpInst::ICMP_SGE };
+        static const CmpInst::Predicate UINT_PREDS[] = { CmpInst::ICMP_EQ, CmpInst::ICMP_NE, CmpInst::ICMP_ULT,
+                                                         CmpInst::ICMP_ULE, CmpInst::ICMP_UGT, CmpInst::ICMP_UGE };
+        auto otherV = this->operands->at( 1 )->code_gen_expr( context, scope );
+        auto predIx = this->op - TXVOP_EQ;
+        if ( isFloat )
+            return scope->builder->CreateFCmp( FLOAT_PREDS[predIx], vecV, otherV );
+        return scope->builder->CreateICmp( ( isSigned ? SINT_PREDS[predIx] : UINT_PREDS[predIx] ), vecV, otherV );
+    }
+
+    case TXVOP_SELECT: {
+        auto maskV = this->operands->at( 1 )->code_gen_expr( context, scope );
+        auto otherV = this->operands->at( 2 )->code_gen_expr( context, scope );
+        return scope->builder->CreateSelect( maskV, vecV, otherV );
+    }
+
+    case TXVOP_ANY: {
+        auto bitsV = gen_lane_bits( context, scope, gen_nonzero_lanes( scope, vecV ) );
+        return scope->builder->CreateICmpNE( bitsV, Constant::getNullValue( bitsV->getType() ) );
+    }
+
+    case TXVOP_ALL:
+        return gen_vector_all_lanes( context, scope, gen_nonzero_lanes( scope, vecV ) );
+
+    default:
+        THROW_LOGIC( "Unhandled vector operation " << this->op << " in " << this );
+    }
+}
+
+
+void TxVectorStoreStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) const {
+    TRACE_CODEGEN( this, context );
+    auto i64T = Type::getInt64Ty( context.llvmContext );
+    auto lanes = get_lanes( this, vector_type( this->vec ) );
+    auto vecV = this->vec->code_gen_expr( context, scope );
+    auto arrayPtrV = this->dst->code_gen_addr( context, scope );
+    auto ixV = this->ix->code_gen_expr( context, scope );
+
+    // check that the range starts within or directly after the current length and ends within the capacity:
+    auto capPtrV = scope->builder->CreateStructGEP( arrayPtrV->getType()->getPointerElementType(), arrayPtrV, 0 );
+    auto lenPtrV = scope->builder->CreateStructGEP( arrayPtrV->getType()->getPointerElementType(), arrayPtrV, 1 );
+    auto capV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( capPtrV ), context.get_tbaa_array_header_tag( 0 ) );
+    auto curLenV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( lenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
+    auto end64V = scope->builder->CreateAdd( scope->builder->CreateZExt( ixV, i64T ), ConstantInt::get( i64T, lanes ) );
+    auto condV = scope->builder->CreateOr( scope->builder->CreateICmpUGT( ixV, curLenV ),
+                                           scope->builder->CreateICmpUGT( end64V, scope->builder->CreateZExt( capV, i64T ) ) );
+    gen_panic_if( context, scope, condV, this->panicNode );
+
+    gen_vector_store( scope, vecV, gen_array_elem_ptr( context, scope, arrayPtrV, ixV ) );
+
+    auto endV = scope->builder->CreateTrunc( end64V, curLenV->getType() );
+    auto newLenV = scope->builder->CreateSelect( scope->builder->CreateICmpUGT( endV, curLenV ), endV, curLenV );
+    LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateStore( newLenV, lenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
+}
@@ -4,6 +4,7 @@
 #include "ast/expr/ast_expr_node.hpp"
 
 class TxAssertStmtNode : public TxStatementNode {
+    friend class TxConstEvaluator;
     TxExpressionNode* expr;
     TxStatementNode* ifStmt;
 
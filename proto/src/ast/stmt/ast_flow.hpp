@@ -60,6 +60,7 @@ public:
 
 
 class TxCondClauseNode : public TxFlowHeaderNode {
+    friend class TxConstEvaluator;
     TxMaybeConversionNode* condExpr;
 
 public:
@@ -119,6 +120,7 @@ public:
 
 
 class TxForHeaderNode : public TxFlowHeaderNode {
+    friend class TxConstEvaluator;
     TxStatementNode* initStmt;
     TxExprStmtNode*  nextCond;
     TxStatementNode* stepStmt;
@@ -208,6 +210,7 @@ public:
 
 
 class TxIfStmtNode : public TxStatementNode {
+    friend class TxConstEvaluator;
     TxFlowHeaderNode* header;
     TxStatementNode* body;
     TxElseClauseNode* elseClause;
@@ -257,6 +260,7 @@ public:
 
 
 class TxForStmtNode : public TxStatementNode {
+    friend class TxConstEvaluator;
     std::vector<TxFlowHeaderNode*>* loopHeaders;
     TxStatementNode* body;
     TxElseClauseNode* elseClause;
@@ -1,4 +1,5 @@
 #include "ast_flow.hpp"
+#include "ast_panicstmt_node.hpp"
 #include "ast/expr/ast_ref.hpp"
 
 #include "llvm_generator.hpp"
@@ -83,7 +84,9 @@ void TxIfStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) c
     }
     else {
         postBlock = BasicBlock::Create( context.llvmContext, "if_post"+id, parentFunc );
-        scope->builder->CreateCondBr( condVal, trueBlock, postBlock );
+        // a branch to a panic (e.g. a failed assert) is marked as unlikely:
+        auto weightsMD = ( dynamic_cast<const TxPanicStmtNode*>( this->body ) ? context.get_panic_branch_weights() : nullptr );
+        scope->builder->CreateCondBr( condVal, trueBlock, postBlock, weightsMD );
     }
 
     // generate true code:
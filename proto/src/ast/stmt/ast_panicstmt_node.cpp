@@ -17,13 +17,18 @@ TxPanicStmtNode::TxPanicStmtNode( const TxLocation& ploc, TxExpressionNode* mess
     auto printCallExpr = new TxFunctionCallNode( this->ploc, printCallee, new std::vector<TxExpressionNode*>( { panicMsgExpr } ) );
     TxStatementNode* printStmt = new TxCallStmtNode( this->ploc, printCallExpr );
 
+    // flush the buffered output (including the panic message) before aborting
+    auto flushCallee = new TxFieldValueNode( this->ploc, nullptr, "tx.tx_flush_output" );
+    auto flushCallExpr = new TxFunctionCallNode( this->ploc, flushCallee, new std::vector<TxExpressionNode*>() );
+    TxStatementNode* flushStmt = new TxCallStmtNode( this->ploc, flushCallExpr );
+
     // we call c library abort() upon assertion failure
     auto abortCallee = new TxFieldValueNode( this->ploc, nullptr, "tx.c.abort" );
     auto abortCallExpr = new TxFunctionCallNode( this->ploc, abortCallee, new std::vector<TxExpressionNode*>(), true );
     TxStatementNode* abortStmt = new TxCallStmtNode( this->ploc, abortCallExpr );
 
     //this->suite = new TxSuiteNode( this->ploc, new std::vector<TxStatementNode*>( { abortStmt } ) );
-    this->suite = new TxSuiteNode( this->ploc, new std::vector<TxStatementNode*>( { printStmt, abortStmt } ) );
+    this->suite = new TxSuiteNode( this->ploc, new std::vector<TxStatementNode*>( { printStmt, flushStmt, abortStmt } ) );
 }
 
 TxPanicStmtNode::TxPanicStmtNode( const TxLocation& ploc, const std::string& message )
@@ -33,7 +38,18 @@ TxPanicStmtNode::TxPanicStmtNode( const TxLocation& ploc, const std::string& mes
         msg << *this->ploc.begin.filename;
     msg << ":" << this->ploc.begin.line;
     msg << ": Panic: " << message;
-    std::string panicMsg = "c\"" + msg.str() + "\n\"";
+    this->fixedMessage = msg.str();
+    this->init_fixed_message_suite();
+}
+
+TxPanicStmtNode* TxPanicStmtNode::make_fixed_message_panic( const TxLocation& ploc, const std::string& fixedMessage ) {
+    auto panicNode = new TxPanicStmtNode( ploc, nullptr, fixedMessage );
+    panicNode->init_fixed_message_suite();
+    return panicNode;
+}
+
+void TxPanicStmtNode::init_fixed_message_suite() {
+    std::string panicMsg = "c\"" + this->fixedMessage + "\n\"";
     auto msgExpr = new TxReferenceToNode( this->ploc, new TxCStringLitNode( this->ploc, panicMsg ) );
 
     auto stderrArg = new TxFieldValueNode( this->ploc, nullptr, "tx.c.stderr" );
@@ -41,10 +57,15 @@ TxPanicStmtNode::TxPanicStmtNode( const TxLocation& ploc, const std::string& mes
     auto putsCallExpr = new TxFunctionCallNode( this->ploc, putsCallee, new std::vector<TxExpressionNode*>( { msgExpr, stderrArg } ) );
     TxStatementNode* putsStmt = new TxCallStmtNode( this->ploc, putsCallExpr );
 
+    // flush the buffered output so that it precedes the panic message
+    auto flushCallee = new TxFieldValueNode( this->ploc, nullptr, "tx.tx_flush_output" );
+    auto flushCallExpr = new TxFunctionCallNode( this->ploc, flushCallee, new std::vector<TxExpressionNode*>() );
+    TxStatementNode* flushStmt = new TxCallStmtNode( this->ploc, flushCallExpr );
+
     // we call c library abort() upon assertion failure
     auto abortCallee = new TxFieldValueNode( this->ploc, nullptr, "tx.c.abort" );
     auto abortCallExpr = new TxFunctionCallNode( this->ploc, abortCallee, new std::vector<TxExpressionNode*>(), true );
     TxStatementNode* abortStmt = new TxCallStmtNode( this->ploc, abortCallExpr );
 
-    this->suite = new TxSuiteNode( this->ploc, new std::vector<TxStatementNode*>( { putsStmt, abortStmt } ) );
+    this->suite = new TxSuiteNode( this->ploc, new std::vector<TxStatementNode*>( { flushStmt, putsStmt, abortStmt } ) );
 }
@@ -6,20 +6,30 @@
 /** Causes an unconditional 'panic'.
  * Currently this results in a program abort.
  * (In future this might be replaced with an exception mechanism.)
+ * A panic with a fixed message is generated as a call to an outlined, cold function shared by all panics
+ * with the same message, so that the panic path doesn't burden the code it is part of.
  */
 class TxPanicStmtNode : public TxStatementNode {
     TxStatementNode* suite;
+    /** the complete panic message if it is fixed, empty if it is computed at run time */
+    std::string fixedMessage;
 
-    TxPanicStmtNode( const TxLocation& ploc, TxStatementNode* suite )
-        : TxStatementNode( ploc ), suite( suite )  { }
+    TxPanicStmtNode( const TxLocation& ploc, TxStatementNode* suite, const std::string& fixedMessage )
+        : TxStatementNode( ploc ), suite( suite ), fixedMessage( fixedMessage )  { }
+
+    void init_fixed_message_suite();
 
 public:
     TxPanicStmtNode( const TxLocation& ploc, TxExpressionNode* messageExpr );
 
+    /** Creates a panic with the message "<source location>: Panic: <message>". */
     TxPanicStmtNode( const TxLocation& ploc, const std::string& message );
 
+    /** Creates a panic with the specified complete message (which is not prefixed with the source location). */
+    static TxPanicStmtNode* make_fixed_message_panic( const TxLocation& ploc, const std::string& fixedMessage );
+
     virtual TxPanicStmtNode* make_ast_copy() const override {
-        return new TxPanicStmtNode( this->ploc, this->suite->make_ast_copy() );
+        return new TxPanicStmtNode( this->ploc, this->suite->make_ast_copy(), this->fixedMessage );
     }
 
     virtual void symbol_resolution_pass() override {
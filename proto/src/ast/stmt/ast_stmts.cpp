@@ -1,6 +1,7 @@
 #include "ast_stmts.hpp"
 
 #include "ast_panicstmt_node.hpp"
+#include "ast/ast_declpass.hpp"
 #include "ast/expr/ast_lambda_node.hpp"
 #include "parsercontext.hpp"
 
@@ -105,6 +106,105 @@ void TxArrayCopyStmtNode::symbol_resolution_pass() {
     this->panicNode->symbol_resolution_pass();
 }
 
+
+/** Resolves an array operand of a bulk array intrinsic; if the operand is a reference to an array it is dereferenced.
+ * If modified is true, the array must be modifiable (unless in a constructor).
+ * Returns the array type, or nullptr if the operand is not an array. */
+static const TxType* resolve_array_operand( TxStatementNode* stmt, TxMaybeConversionNode* arrayNode, bool modified ) {
+    auto opType = arrayNode->originalExpr->resolve_type();
+    bool modifiable = opType->is_modifiable();
+    if ( opType->get_type_class() == TXTC_REFERENCE ) {
+        auto targType = opType->type()->target_type();
+        if ( targType->get_type_class() == TXTC_ARRAY ) {
+            arrayNode->insert_conversion( targType->type() );
+            modifiable = targType->is_modifiable();
+        }
+    }
+    arrayNode->symbol_resolution_pass();
+    auto arrayType = arrayNode->qualtype()->type();
+    if ( arrayType->get_type_class() != TXTC_ARRAY ) {
+        CERROR( arrayNode, "Operand is not an array: " << arrayNode->qualtype() );
+        return nullptr;
+    }
+
+    if ( modified && !( stmt->context().enclosing_lambda() && stmt->context().enclosing_lambda()->get_constructed() ) ) {
+        if ( !modifiable && !arrayType->is_generic_param() )
+            CERROR( arrayNode, "Array operand is not modifiable: " << arrayNode->qualtype() );
+        else
+            arrayNode->originalExpr->check_chain_mutable();
+    }
+    return arrayType;
+}
+
+static void resolve_index_operand( TxStatementNode* stmt, TxMaybeConversionNode* indexNode ) {
+    indexNode->insert_conversion( stmt->registry().get_builtin_type( ARRAY_SUBSCRIPT_TYPE_ID ) );
+    indexNode->symbol_resolution_pass();
+}
+
+/** Creates a conversion of a source array element to the destination's element type, if the element types differ.
+ * It is used when the element representations turn out to differ, in which case the elements can't simply be mem-copied.
+ * Returns null if the element types are the same. */
+static TxMaybeConversionNode* make_elem_conversion( TxStatementNode* stmt, const TxType* srcArrayType, const TxType* dstArrayType ) {
+    auto srcElemType = srcArrayType->element_type();
+    auto dstElemType = dstArrayType->element_type()->type();
+    if ( stmt->context().is_generic() || *srcElemType->type()->acttype() == *dstElemType->acttype() )
+        return nullptr;
+    auto elemConv = new TxMaybeConversionNode( new TxArrayElemValueNode( stmt->ploc, srcElemType ) );
+    run_declaration_pass( elemConv, stmt, "elemconv" );
+    elemConv->insert_conversion( dstElemType );
+    elemConv->symbol_resolution_pass();
+    return elemConv;
+}
+
+TxArrayRangeCopyStmtNode::TxArrayRangeCopyStmtNode( const TxLocation& ploc, TxExpressionNode* dst, TxExpressionNode* dstIx,
+                                                    TxExpressionNode* src, TxExpressionNode* srcIx, TxExpressionNode* len )
+        : TxStatementNode( ploc ), dst( new TxMaybeConversionNode( dst ) ),
+          dstIx( dstIx ? new TxMaybeConversionNode( dstIx ) : nullptr ),
+          src( new TxMaybeConversionNode( src ) ),
+          srcIx( srcIx ? new TxMaybeConversionNode( srcIx ) : nullptr ),
+          len( len ? new TxMaybeConversionNode( len ) : nullptr ) {
+    ASSERT( ( srcIx == nullptr ) == ( len == nullptr ), "Source index and length must be either both or neither specified" );
+    this->panicNode = new TxPanicStmtNode( ploc, "Array range copy out of bounds" );
+}
+
+void TxArrayRangeCopyStmtNode::symbol_resolution_pass() {
+    auto dstType = resolve_array_operand( this, this->dst, true );
+    auto srcType = resolve_array_operand( this, this->src, false );
+    if ( dstType && srcType ) {
+        auto dstElemType = dstType->element_type()->type()->acttype();
+        auto srcElemType = srcType->element_type()->type()->acttype();
+        if ( !srcElemType->is_assignable_to( *dstElemType ) ) {
+            if ( !dstElemType->is_generic_param() )
+                CERROR( this, "Source array's element type " << srcElemType << " is not assignable to destination's " << dstElemType );
+        }
+        else
+            this->elemConv = make_elem_conversion( this, srcType, dstType );
+    }
+    if ( this->dstIx )
+        resolve_index_operand( this, this->dstIx );
+    if ( this->srcIx ) {
+        resolve_index_operand( this, this->srcIx );
+        resolve_index_operand( this, this->len );
+    }
+    this->panicNode->symbol_resolution_pass();
+}
+
+TxArrayFillStmtNode::TxArrayFillStmtNode( const TxLocation& ploc, TxExpressionNode* dst, TxExpressionNode* ix,
+                                          TxExpressionNode* len, TxExpressionNode* value )
+        : TxStatementNode( ploc ), dst( new TxMaybeConversionNode( dst ) ), ix( new TxMaybeConversionNode( ix ) ),
+          len( new TxMaybeConversionNode( len ) ), value( new TxMaybeConversionNode( value ) ) {
+    this->panicNode = new TxPanicStmtNode( ploc, "Array range fill out of bounds" );
+}
+
+void TxArrayFillStmtNode::symbol_resolution_pass() {
+    if ( auto dstType = resolve_array_operand( this, this->dst, true ) )
+        this->value->insert_conversion( dstType->element_type()->type() );
+    this->value->symbol_resolution_pass();
+    resolve_index_operand( this, this->ix );
+    resolve_index_operand( this, this->len );
+    this->panicNode->symbol_resolution_pass();
+}
+
 void TxExpErrStmtNode::stmt_declaration_pass() {
     //this->lexContext._scope = lexContext.scope()->create_code_block_scope( *this, "EE" );
     this->lexContext.expErrCtx = this->expError;
@@ -314,6 +314,120 @@ public:
     }
 };
 
+/** Stands in for a source element value in a bulk array range copy, so that a conversion to the destination's element type
+ * can be generated for it. The owning statement sets the loaded element value before generating the conversion. */
+class TxArrayElemValueNode : public TxExpressionNode {
+    const TxQualType* elemType;
+
+protected:
+    virtual const TxQualType* define_type() override {
+        return this->elemType;
+    }
+
+public:
+    mutable llvm::Value* elemValueV = nullptr;
+
+    TxArrayElemValueNode( const TxLocation& ploc, const TxQualType* elemType )
+            : TxExpressionNode( ploc ), elemType( elemType ) {
+    }
+
+    virtual TxArrayElemValueNode* make_ast_copy() const override {
+        return new TxArrayElemValueNode( this->ploc, this->elemType );
+    }
+
+    virtual llvm::Value* code_gen_dyn_value( LlvmGenerationContext& context, GenScope* scope ) const override {
+        return this->elemValueV;
+    }
+
+    virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
+    }
+};
+
+/** Intrinsic bulk copy of a range of array elements:
+ *     _copy( dst, dstIx, src, srcIx, len )
+ *     _append( dst, src )
+ *     _append( dst, src, srcIx, len )
+ * Copies len elements starting at src[srcIx] into dst starting at dst[dstIx] (dst.L for _append),
+ * and extends dst.L if the copied range ends past it.
+ * All bounds are checked once for the whole range. If the element types have the same representation the data
+ * is moved with a single memmove (source and destination may overlap), otherwise the elements are converted one by one.
+ */
+class TxArrayRangeCopyStmtNode : public TxStatementNode {
+    class TxStatementNode* panicNode;
+    TxMaybeConversionNode* elemConv = nullptr;  // set if the element types differ
+
+public:
+    TxMaybeConversionNode* dst;
+    TxMaybeConversionNode* dstIx;  // null for append
+    TxMaybeConversionNode* src;
+    TxMaybeConversionNode* srcIx;  // null for append whole source
+    TxMaybeConversionNode* len;    // null for append whole source
+
+    TxArrayRangeCopyStmtNode( const TxLocation& ploc, TxExpressionNode* dst, TxExpressionNode* dstIx,
+                              TxExpressionNode* src, TxExpressionNode* srcIx, TxExpressionNode* len );
+
+    virtual TxArrayRangeCopyStmtNode* make_ast_copy() const override {
+        return new TxArrayRangeCopyStmtNode( this->ploc, this->dst->originalExpr->make_ast_copy(),
+                                             ( this->dstIx ? this->dstIx->originalExpr->make_ast_copy() : nullptr ),
+                                             this->src->originalExpr->make_ast_copy(),
+                                             ( this->srcIx ? this->srcIx->originalExpr->make_ast_copy() : nullptr ),
+                                             ( this->len ? this->len->originalExpr->make_ast_copy() : nullptr ) );
+    }
+
+    virtual void symbol_resolution_pass() override;
+
+    virtual void code_gen( LlvmGenerationContext& context, GenScope* scope ) const override;
+
+    virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
+        this->dst->visit_ast( visitor, thisCursor, "dst", context );
+        if ( this->dstIx )
+            this->dstIx->visit_ast( visitor, thisCursor, "dstix", context );
+        this->src->visit_ast( visitor, thisCursor, "src", context );
+        if ( this->srcIx )
+            this->srcIx->visit_ast( visitor, thisCursor, "srcix", context );
+        if ( this->len )
+            this->len->visit_ast( visitor, thisCursor, "len", context );
+        if ( this->elemConv )
+            this->elemConv->visit_ast( visitor, thisCursor, "elemconv", context );
+        this->panicNode->visit_ast( visitor, thisCursor, "panic", context );
+    }
+};
+
+/** Intrinsic bulk fill of a range of array elements:
+ *     _fill( dst, ix, len, value )
+ * Sets len elements starting at dst[ix] to value, and extends dst.L if the range ends past it.
+ * The bounds are checked once for the whole range. Byte-sized elements are filled with a memset.
+ */
+class TxArrayFillStmtNode : public TxStatementNode {
+    class TxStatementNode* panicNode;
+
+public:
+    TxMaybeConversionNode* dst;
+    TxMaybeConversionNode* ix;
+    TxMaybeConversionNode* len;
+    TxMaybeConversionNode* value;
+
+    TxArrayFillStmtNode( const TxLocation& ploc, TxExpressionNode* dst, TxExpressionNode* ix,
+                         TxExpressionNode* len, TxExpressionNode* value );
+
+    virtual TxArrayFillStmtNode* make_ast_copy() const override {
+        return new TxArrayFillStmtNode( this->ploc, this->dst->originalExpr->make_ast_copy(), this->ix->originalExpr->make_ast_copy(),
+                                        this->len->originalExpr->make_ast_copy(), this->value->originalExpr->make_ast_copy() );
+    }
+
+    virtual void symbol_resolution_pass() override;
+
+    virtual void code_gen( LlvmGenerationContext& context, GenScope* scope ) const override;
+
+    virtual void visit_descendants( AstVisitor visitor, const AstCursor& thisCursor, const std::string& role, void* context ) override {
+        this->dst->visit_ast( visitor, thisCursor, "dst", context );
+        this->ix->visit_ast( visitor, thisCursor, "ix", context );
+        this->len->visit_ast( visitor, thisCursor, "len", context );
+        this->value->visit_ast( visitor, thisCursor, "value", context );
+        this->panicNode->visit_ast( visitor, thisCursor, "panic", context );
+    }
+};
+
 class TxExpErrStmtNode : public TxStatementNode {
     ExpectedErrorClause* expError;
 
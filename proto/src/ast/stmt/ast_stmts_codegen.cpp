@@ -25,7 +25,7 @@ void TxAssignStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope
     auto lval = this->lvalue->code_gen_address( context, scope );
     auto rval = this->rvalue->code_gen_expr( context, scope );
     ASSERT ( lval->getType()->isPointerTy(), "At " << this->parse_loc_string() << ": L-value is not of pointer type:\n" << ::to_string(lval) );
-    scope->builder->CreateStore( rval, lval );
+    LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateStore( rval, lval ), this->lvalue->get_tbaa_tag( context ) );
 }
 
 void TxAssertStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) const {
@@ -36,13 +36,28 @@ void TxAssertStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope
 
 void TxPanicStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) const {
     TRACE_CODEGEN( this, context );
-    this->suite->code_gen( context, scope );
+    if ( this->fixedMessage.empty() ) {
+        this->suite->code_gen( context, scope );
+        return;
+    }
+
+    // a panic with a fixed message is a call to the shared, outlined panic function for that message:
+    auto thunkF = context.get_panic_thunk( this->fixedMessage );
+    if ( thunkF->empty() ) {
+        IRBuilder<> builder( BasicBlock::Create( context.llvmContext, "entry", thunkF ) );
+        GenScope thunkScope( &builder );
+        this->suite->code_gen( context, &thunkScope );
+        builder.CreateUnreachable();
+    }
+    scope->builder->CreateCall( thunkF );
 }
 
 void TxSuiteNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) const {
     TRACE_CODEGEN( this, context );
-    for ( auto stmt : *this->suite )
+    for ( auto stmt : *this->suite ) {
+        context.gen_debug_location( scope, stmt );
         stmt->code_gen( context, scope );
+    }
 }
 
 void TxExprStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) const {
@@ -79,7 +94,7 @@ void TxArrayCopyStmtNode::code_gen( LlvmGenerationContext& context, GenScope* sc
     Value* lenIxs[] = { ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ),
                         ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 1 ) };
     auto srcLenPtrV = scope->builder->CreateInBoundsGEP( rvalArrayPtrV, lenIxs );
-    auto srcLenV = scope->builder->CreateLoad( srcLenPtrV );
+    auto srcLenV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( srcLenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
 
     { // add bounds check:
         auto parentFunc = scope->builder->GetInsertBlock()->getParent();
@@ -89,10 +104,10 @@ void TxArrayCopyStmtNode::code_gen( LlvmGenerationContext& context, GenScope* sc
         Value* capIxs[] = { ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ),
                             ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ) };
         auto dstCapPtrV = scope->builder->CreateInBoundsGEP( lvalArrayPtrV, capIxs );
-        auto dstCapV = scope->builder->CreateLoad( dstCapPtrV );
+        auto dstCapV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( dstCapPtrV ), context.get_tbaa_array_header_tag( 0 ) );
 
         auto condV = scope->builder->CreateICmpULT( dstCapV, srcLenV );
-        scope->builder->CreateCondBr( condV, trueBlock, nextBlock );
+        scope->builder->CreateCondBr( condV, trueBlock, nextBlock, context.get_panic_branch_weights() );
 
         { // if assignee has insufficient capacity
             scope->builder->SetInsertPoint( trueBlock );
@@ -105,7 +120,7 @@ void TxArrayCopyStmtNode::code_gen( LlvmGenerationContext& context, GenScope* sc
 
     // set assignee's length equal to source's length:
     auto dstLenPtrV = scope->builder->CreateInBoundsGEP( lvalArrayPtrV, lenIxs );
-    scope->builder->CreateStore( srcLenV, dstLenPtrV );
+    LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateStore( srcLenV, dstLenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
 
     {
         // Current implementation is to memcpy the data. (This will include uninitialized padding bytes.)
@@ -125,3 +140,159 @@ void TxArrayCopyStmtNode::code_gen( LlvmGenerationContext& context, GenScope* sc
         scope->builder->CreateMemCpy( dstDataPtrV, srcDataPtrV, dataSizeV, 8 );
     }
 }
+
+
+/** Generates a branch to the panic statement, taken if condV is true. */
+static void gen_panic_if( LlvmGenerationContext& context, GenScope* scope, Value* condV, const TxStatementNode* panicNode ) {
+    auto parentFunc = scope->builder->GetInsertBlock()->getParent();
+    BasicBlock* trueBlock = BasicBlock::Create( context.llvmContext, "if_true", parentFunc );
+    BasicBlock* nextBlock = BasicBlock::Create( context.llvmContext, "if_next", parentFunc );
+    scope->builder->CreateCondBr( condV, trueBlock, nextBlock, context.get_panic_branch_weights() );
+
+    scope->builder->SetInsertPoint( trueBlock );
+    panicNode->code_gen( context, scope );
+    scope->builder->CreateBr( nextBlock );  // terminate block, though won't be executed
+
+    scope->builder->SetInsertPoint( nextBlock );
+}
+
+/** Returns a pointer to the array's element at the given index (without bounds checking). */
+static Value* gen_array_elem_ptr( LlvmGenerationContext& context, GenScope* scope, Value* arrayPtrV, Value* ixV ) {
+    Value* ixs[] = { ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ),
+                     ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 2 ),
+                     ixV };
+    return scope->builder->CreateInBoundsGEP( arrayPtrV, ixs );
+}
+
+/** Checks that the range [ixV, ixV+lenV) of the destination array is within its capacity and starts within or directly after
+ * its current length, and then extends its length to cover the range. */
+static void gen_dst_range_check_and_extend( LlvmGenerationContext& context, GenScope* scope, Value* arrayPtrV,
+                                            Value* ixV, Value* lenV, Value* extraCondV, const TxStatementNode* panicNode ) {
+    auto i64T = Type::getInt64Ty( context.llvmContext );
+    auto capPtrV = scope->builder->CreateStructGEP( arrayPtrV->getType()->getPointerElementType(), arrayPtrV, 0 );
+    auto lenPtrV = scope->builder->CreateStructGEP( arrayPtrV->getType()->getPointerElementType(), arrayPtrV, 1 );
+    auto capV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( capPtrV ), context.get_tbaa_array_header_tag( 0 ) );
+    auto curLenV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( lenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
+
+    // (the range end is computed in 64 bits so that overflow can't bypass the check)
+    auto end64V = scope->builder->CreateAdd( scope->builder->CreateZExt( ixV, i64T ), scope->builder->CreateZExt( lenV, i64T ) );
+    auto condV = scope->builder->CreateOr( scope->builder->CreateICmpUGT( ixV, curLenV ),
+                                           scope->builder->CreateICmpUGT( end64V, scope->builder->CreateZExt( capV, i64T ) ) );
+    if ( extraCondV )
+        condV = scope->builder->CreateOr( extraCondV, condV );
+    gen_panic_if( context, scope, condV, panicNode );
+
+    auto endV = scope->builder->CreateTrunc( end64V, curLenV->getType() );
+    auto newLenV = scope->builder->CreateSelect( scope->builder->CreateICmpUGT( endV, curLenV ), endV, curLenV );
+    LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateStore( newLenV, lenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
+}
+
+/** Copies len elements one by one from srcElemPtrV to dstElemPtrV, converting each to the destination's element type.
+ * (Source and destination can't overlap since their element types differ.) */
+static void gen_elem_conversion_loop( LlvmGenerationContext& context, GenScope* scope, Value* dstElemPtrV, Value* srcElemPtrV,
+                                      Value* lenV, const TxMaybeConversionNode* elemConv ) {
+    auto elemValueNode = static_cast<const TxArrayElemValueNode*>( elemConv->originalExpr );
+    auto parentFunc = scope->builder->GetInsertBlock()->getParent();
+    auto preBlock = scope->builder->GetInsertBlock();
+    BasicBlock* loopBlock = BasicBlock::Create( context.llvmContext, "conv_loop", parentFunc );
+    BasicBlock* postBlock = BasicBlock::Create( context.llvmContext, "conv_post", parentFunc );
+    auto zeroV = ConstantInt::get( lenV->getType(), 0 );
+    scope->builder->CreateCondBr( scope->builder->CreateICmpEQ( lenV, zeroV ), postBlock, loopBlock );
+
+    scope->builder->SetInsertPoint( loopBlock );
+    auto counterV = scope->builder->CreatePHI( lenV->getType(), 2, "conv_ix" );
+    counterV->addIncoming( zeroV, preBlock );
+    elemValueNode->elemValueV = scope->builder->CreateLoad( scope->builder->CreateInBoundsGEP( srcElemPtrV, counterV ) );
+    auto convElemV = elemConv->code_gen_expr( context, scope );
+    scope->builder->CreateStore( convElemV, scope->builder->CreateInBoundsGEP( dstElemPtrV, counterV ) );
+    auto nextV = scope->builder->CreateAdd( counterV, ConstantInt::get( lenV->getType(), 1 ) );
+    counterV->addIncoming( nextV, scope->builder->GetInsertBlock() );
+    scope->builder->CreateCondBr( scope->builder->CreateICmpULT( nextV, lenV ), loopBlock, postBlock );
+
+    scope->builder->SetInsertPoint( postBlock );
+}
+
+void TxArrayRangeCopyStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) const {
+    TRACE_CODEGEN( this, context );
+    auto i64T = Type::getInt64Ty( context.llvmContext );
+    auto dstArrayPtrV = this->dst->code_gen_addr( context, scope );
+    auto srcArrayPtrV = this->src->code_gen_addr( context, scope );
+
+    Value* dstIxV;
+    if ( this->dstIx )
+        dstIxV = this->dstIx->code_gen_expr( context, scope );
+    else {
+        auto dstLenPtrV = scope->builder->CreateStructGEP( dstArrayPtrV->getType()->getPointerElementType(), dstArrayPtrV, 1 );
+        dstIxV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( dstLenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
+    }
+
+    auto srcLenPtrV = scope->builder->CreateStructGEP( srcArrayPtrV->getType()->getPointerElementType(), srcArrayPtrV, 1 );
+    auto srcLenV = LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateLoad( srcLenPtrV ), context.get_tbaa_array_header_tag( 1 ) );
+    Value* srcIxV;
+    Value* lenV;
+    Value* srcCondV = nullptr;
+    if ( this->srcIx ) {
+        srcIxV = this->srcIx->code_gen_expr( context, scope );
+        lenV = this->len->code_gen_expr( context, scope );
+        auto srcEnd64V = scope->builder->CreateAdd( scope->builder->CreateZExt( srcIxV, i64T ), scope->builder->CreateZExt( lenV, i64T ) );
+        srcCondV = scope->builder->CreateICmpUGT( srcEnd64V, scope->builder->CreateZExt( srcLenV, i64T ) );
+    }
+    else {
+        srcIxV = ConstantInt::get( srcLenV->getType(), 0 );
+        lenV = srcLenV;
+    }
+
+    gen_dst_range_check_and_extend( context, scope, dstArrayPtrV, dstIxV, lenV, srcCondV, this->panicNode );
+
+    auto dstDataPtrV = gen_array_elem_ptr( context, scope, dstArrayPtrV, dstIxV );
+    auto srcDataPtrV = gen_array_elem_ptr( context, scope, srcArrayPtrV, srcIxV );
+    if ( dstDataPtrV->getType() != srcDataPtrV->getType() ) {
+        // The element types are assignable but their representations differ (e.g. references that need an interface adapter),
+        // so the elements can't be mem-moved.
+        if ( !this->elemConv )
+            CERR_CODECHECK( this, "Array element representations differ but there is no element conversion" );
+        gen_elem_conversion_loop( context, scope, dstDataPtrV, srcDataPtrV, lenV, this->elemConv );
+        return;
+    }
+
+    // Current implementation is to memmove the data, as for whole-array assignment. (Source and destination may overlap.)
+    auto dstTypeIdV = this->dst->code_gen_typeid( context, scope );
+    auto elemSizeV = context.gen_get_element_size( scope, this->dst->qualtype()->type()->acttype(), dstTypeIdV );
+    auto dataSizeV = scope->builder->CreateMul( scope->builder->CreateZExtOrBitCast( elemSizeV, i64T ),
+                                                scope->builder->CreateZExt( lenV, i64T ), "datasize" );
+    scope->builder->CreateMemMove( dstDataPtrV, srcDataPtrV, dataSizeV, 1 );
+}
+
+void TxArrayFillStmtNode::code_gen( LlvmGenerationContext& context, GenScope* scope ) const {
+    TRACE_CODEGEN( this, context );
+    auto dstArrayPtrV = this->dst->code_gen_addr( context, scope );
+    auto ixV = this->ix->code_gen_expr( context, scope );
+    auto lenV = this->len->code_gen_expr( context, scope );
+    auto valueV = this->value->code_gen_expr( context, scope );
+
+    gen_dst_range_check_and_extend( context, scope, dstArrayPtrV, ixV, lenV, nullptr, this->panicNode );
+
+    auto elemPtrV = gen_array_elem_ptr( context, scope, dstArrayPtrV, ixV );
+    if ( valueV->getType()->isIntegerTy( 8 ) ) {
+        scope->builder->CreateMemSet( elemPtrV, valueV, scope->builder->CreateZExt( lenV, Type::getInt64Ty( context.llvmContext ) ), 1 );
+        return;
+    }
+
+    // store loop without per-element bounds checks:
+    auto parentFunc = scope->builder->GetInsertBlock()->getParent();
+    auto preBlock = scope->builder->GetInsertBlock();
+    BasicBlock* loopBlock = BasicBlock::Create( context.llvmContext, "fill_loop", parentFunc );
+    BasicBlock* postBlock = BasicBlock::Create( context.llvmContext, "fill_post", parentFunc );
+    auto zeroV = ConstantInt::get( lenV->getType(), 0 );
+    scope->builder->CreateCondBr( scope->builder->CreateICmpEQ( lenV, zeroV ), postBlock, loopBlock );
+
+    scope->builder->SetInsertPoint( loopBlock );
+    auto counterV = scope->builder->CreatePHI( lenV->getType(), 2, "fill_ix" );
+    counterV->addIncoming( zeroV, preBlock );
+    scope->builder->CreateStore( valueV, scope->builder->CreateInBoundsGEP( elemPtrV, counterV ) );
+    auto nextV = scope->builder->CreateAdd( counterV, ConstantInt::get( lenV->getType(), 1 ) );
+    counterV->addIncoming( nextV, loopBlock );
+    scope->builder->CreateCondBr( scope->builder->CreateICmpULT( nextV, lenV ), loopBlock, postBlock );
+
+    scope->builder->SetInsertPoint( postBlock );
+}
@@ -18,6 +18,8 @@
 #include "ast/expr/ast_field.hpp"
 #include "ast/expr/ast_lambda_node.hpp"
 #include "ast/expr/ast_op_exprs.hpp"
+#include "ast/expr/ast_intrinsics.hpp"
+#include "ast/expr/ast_vector.hpp"
 #include "ast/stmt/ast_stmts.hpp"
 
 /*--- statically allocated built-in type objects ---*/
@@ -48,6 +50,7 @@ std::vector<std::string> BUILTIN_TYPE_NAMES = {
                                                 "Array",
                                                 "Function",
                                                 "Tuple",
+                                                "Vec",
 };
 
 
@@ -462,6 +465,29 @@ public:
     }
 };
 
+class TxVecTypeDefNode final : public TxBuiltinTypeDefiningNode {
+    TxVecTypeDefNode( const TxLocation& ploc, const TxVecTypeDefNode* original,
+                      TxTypeExpressionNode* baseTypeNode, const std::vector<TxDeclarationNode*>& declNodes, TxDerivedTypeNode* sourcecodeDefiner )
+            : TxBuiltinTypeDefiningNode( ploc, original, baseTypeNode, declNodes, sourcecodeDefiner ) {
+    }
+protected:
+    virtual TxActualType* make_builtin_type( const TxTypeDeclaration* declaration, const TxType* baseType,
+                                             const std::vector<const TxActualType*>& ifSpecs, bool mutableType ) override {
+        return new TxVectorType( declaration, baseType->acttype(), ifSpecs );
+    }
+public:
+    TxVecTypeDefNode( const TxLocation& ploc, TxTypeExpressionNode* baseTypeNode,
+                      const std::vector<TxDeclarationNode*>& declNodes,
+                      const TxVecTypeDefNode* original = nullptr )
+            : TxBuiltinTypeDefiningNode( ploc, TXBT_VECTOR, baseTypeNode, declNodes ) {
+    }
+
+    virtual TxVecTypeDefNode* make_ast_copy() const override {
+        return new TxVecTypeDefNode( this->ploc, this, this->baseTypeNode->make_ast_copy(), make_node_vec_copy( this->declNodes ),
+                                     ( this->sourcecodeDefiner ? this->sourcecodeDefiner->make_ast_copy() : nullptr ) );
+    }
+};
+
 /*----- built-in constructor / initializer type defining AST nodes -----*/
 
 class TxBuiltinConstructorTypeDefNode : public TxFunctionTypeNode {
@@ -602,6 +628,15 @@ static std::vector<TxDeclarationNode*> make_any_methods( const TxLocation& loc )
                                                 new TxNonLocalFieldDefNode( loc, "equals", (TxTypeExpressionNode*)nullptr, lambdaExpr ),
                                                 true ) );  // method syntax
     }
+    { //  define hash() - identity based, consistent with the default equals()
+        auto hashStmt = new TxReturnStmtNode( loc, new TxRefAddressNode( loc, new TxFieldValueNode( loc, nullptr, "self" ) ) );
+        auto methodType = new TxFunctionTypeNode( loc, false, new std::vector<TxArgTypeDefNode*>(),
+                                                  new TxNamedTypeNode( loc, "tx.ULong" ) );
+        auto lambdaExpr = new TxLambdaExprNode( loc, methodType, new TxSuiteNode( loc, new std::vector<TxStatementNode*>( { hashStmt } ) ), true );
+        methods.push_back( new TxFieldDeclNode( loc, TXD_PUBLIC | TXD_BUILTIN,
+                                                new TxNonLocalFieldDefNode( loc, "hash", (TxTypeExpressionNode*)nullptr, lambdaExpr ),
+                                                true ) );  // method syntax
+    }
     return methods;
 }
 
@@ -647,6 +682,129 @@ static std::vector<TxDeclarationNode*> make_array_methods( const TxLocation& loc
     return methods;
 }
 
+/** Makes a built-in Vec method (or constructor if the name is CONSTR_IDENT) whose body is the specified statement. */
+static TxFieldDeclNode* make_vec_method( const TxLocation& loc, const std::string& name, std::vector<TxArgTypeDefNode*>* args,
+                                         TxTypeExpressionNode* returnType, TxStatementNode* bodyStmt ) {
+    auto methodType = new TxFunctionTypeNode( loc, false, args, returnType );
+    auto lambdaExpr = new TxLambdaExprNode( loc, methodType, new TxSuiteNode( loc, new std::vector<TxStatementNode*>( { bodyStmt } ) ), true );
+    TxDeclarationFlags flags = TXD_PUBLIC | TXD_BUILTIN;
+    if ( name == CONSTR_IDENT )
+        flags |= TXD_CONSTRUCTOR;
+    return new TxFieldDeclNode( loc, flags, new TxNonLocalFieldDefNode( loc, name, (TxTypeExpressionNode*)nullptr, lambdaExpr ),
+                                true );  // method syntax
+}
+
+/** Makes a Vec<E,N> type expression with the specified element type and the same lane count as the enclosing Vec. */
+static TxTypeExpressionNode* make_vec_lanes_type( const TxLocation& loc, const std::string& elemTypeName ) {
+    return new TxGenSpecTypeNode(
+            loc, new TxNamedTypeNode( loc, "tx.Vec" ),
+            new std::vector<TxTypeArgumentNode*>( { new TxTypeTypeArgumentNode( new TxNamedTypeNode( loc, elemTypeName ) ),
+                                                    new TxValueTypeArgumentNode( new TxFieldValueNode( loc, nullptr, "N" ) ) } ) );
+}
+
+static std::vector<TxDeclarationNode*> make_vec_methods( const TxLocation& loc ) {
+    auto selfDeref = [ loc ] () -> TxExpressionNode* {
+        return new TxReferenceDerefNode( loc, new TxFieldValueNode( loc, nullptr, "self" ) );
+    };
+    auto arg = [ loc ] ( const std::string& name ) -> TxExpressionNode* {
+        return new TxFieldValueNode( loc, nullptr, name );
+    };
+    // constructor whose body assigns the result of an intrinsic operation to self^:
+    auto make_constructor = [ loc, selfDeref ] ( std::vector<TxArgTypeDefNode*>* args, TxVectorOp op,
+                                                 std::vector<TxExpressionNode*> operands ) {
+        operands.insert( operands.begin(), selfDeref() );
+        auto initStmt = new TxAssignStmtNode( loc, new TxDerefAssigneeNode( loc, new TxFieldValueNode( loc, nullptr, "self" ) ),
+                                              new TxVectorIntrinsicNode( loc, op, new std::vector<TxExpressionNode*>( operands ) ) );
+        return make_vec_method( loc, CONSTR_IDENT, args, nullptr, initStmt );
+    };
+    // method that returns the result of an intrinsic operation on self^:
+    auto make_intrinsic_method = [ loc, selfDeref ] ( const std::string& name, std::vector<TxArgTypeDefNode*>* args,
+                                                      TxTypeExpressionNode* returnType, TxVectorOp op,
+                                                      std::vector<TxExpressionNode*> operands ) {
+        operands.insert( operands.begin(), selfDeref() );
+        auto returnStmt = new TxReturnStmtNode( loc, new TxVectorIntrinsicNode( loc, op, new std::vector<TxExpressionNode*>( operands ) ) );
+        return make_vec_method( loc, name, args, returnType, returnStmt );
+    };
+    auto noArgs = [] () {
+        return new std::vector<TxArgTypeDefNode*>();
+    };
+    auto otherArg = [ loc ] () {
+        return new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "other", new TxNamedTypeNode( loc, "Self" ) ) } );
+    };
+
+    std::vector<TxDeclarationNode*> methods;
+
+    // constructors:
+    methods.push_back( make_constructor( noArgs(), TXVOP_ZERO, { } ) );
+    methods.push_back( make_constructor( new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "value", new TxNamedTypeNode( loc, "E" ) ) } ),
+                                         TXVOP_SPLAT, { arg( "value" ) } ) );
+    {
+        auto srcTypeNode = new TxReferenceTypeNode( loc, nullptr, new TxArrayTypeNode( loc, new TxConstTypeNode( loc, new TxNamedTypeNode( loc, "E" ) ) ) );
+        auto args = new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "src", srcTypeNode ),
+                                                          new TxArgTypeDefNode( loc, "ix", new TxNamedTypeNode( loc, "tx.UInt" ) ) } );
+        methods.push_back( make_constructor( args, TXVOP_LOAD, { new TxReferenceDerefNode( loc, arg( "src" ) ), arg( "ix" ) } ) );
+    }
+
+    // lane access:
+    methods.push_back( make_intrinsic_method( "lanes", noArgs(), new TxNamedTypeNode( loc, "tx.UInt" ), TXVOP_LANES, { } ) );
+    methods.push_back( make_intrinsic_method( "get", new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "lane", new TxNamedTypeNode( loc, "tx.UInt" ) ) } ),
+                                              new TxNamedTypeNode( loc, "E" ), TXVOP_EXTRACT, { arg( "lane" ) } ) );
+    methods.push_back( make_intrinsic_method( "with_lane",
+                                              new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "lane", new TxNamedTypeNode( loc, "tx.UInt" ) ),
+                                                                                    new TxArgTypeDefNode( loc, "value", new TxNamedTypeNode( loc, "E" ) ) } ),
+                                              new TxNamedTypeNode( loc, "Self" ), TXVOP_INSERT, { arg( "lane" ), arg( "value" ) } ) );
+    {
+        auto dstTypeNode = new TxReferenceTypeNode( loc, nullptr, new TxModifiableTypeNode(
+                loc, new TxArrayTypeNode( loc, new TxMaybeModTypeNode( loc, new TxNamedTypeNode( loc, "E" ) ) ) ) );
+        auto args = new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "dst", dstTypeNode ),
+                                                          new TxArgTypeDefNode( loc, "ix", new TxNamedTypeNode( loc, "tx.UInt" ) ) } );
+        auto storeStmt = new TxVectorStoreStmtNode( loc, selfDeref(), new TxReferenceDerefNode( loc, arg( "dst" ) ), arg( "ix" ) );
+        methods.push_back( make_vec_method( loc, "store", args, nullptr, storeStmt ) );
+    }
+
+    // permutations:
+    methods.push_back( make_intrinsic_method( "shuffle", new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "indices", make_vec_lanes_type( loc, "tx.UInt" ) ) } ),
+                                              new TxNamedTypeNode( loc, "Self" ), TXVOP_SHUFFLE, { arg( "indices" ) } ) );
+    methods.push_back( make_intrinsic_method( "reverse", noArgs(), new TxNamedTypeNode( loc, "Self" ), TXVOP_REVERSE, { } ) );
+
+    // horizontal reductions:
+    const std::vector<std::pair<const char*, TxVectorOp>> reductions = {
+        { "reduce_add", TXVOP_REDUCE_ADD }, { "reduce_mul", TXVOP_REDUCE_MUL },
+        { "reduce_min", TXVOP_REDUCE_MIN }, { "reduce_max", TXVOP_REDUCE_MAX },
+        { "reduce_and", TXVOP_REDUCE_AND }, { "reduce_or", TXVOP_REDUCE_OR }, { "reduce_xor", TXVOP_REDUCE_XOR },
+    };
+    for ( auto & red : reductions )
+        methods.push_back( make_intrinsic_method( red.first, noArgs(), new TxNamedTypeNode( loc, "E" ), red.second, { } ) );
+
+    // lane-wise operations:
+    methods.push_back( make_intrinsic_method( "min", otherArg(), new TxNamedTypeNode( loc, "Self" ), TXVOP_MIN, { arg( "other" ) } ) );
+    methods.push_back( make_intrinsic_method( "max", otherArg(), new TxNamedTypeNode( loc, "Self" ), TXVOP_MAX, { arg( "other" ) } ) );
+
+    const std::vector<std::pair<const char*, TxVectorOp>> comparisons = {
+        { "lanes_eq", TXVOP_EQ }, { "lanes_ne", TXVOP_NE },
+        { "lanes_lt", TXVOP_LT }, { "lanes_le", TXVOP_LE },
+        { "lanes_gt", TXVOP_GT }, { "lanes_ge", TXVOP_GE },
+    };
+    for ( auto & cmp : comparisons )
+        methods.push_back( make_intrinsic_method( cmp.first, otherArg(), make_vec_lanes_type( loc, "tx.Bool" ), cmp.second, { arg( "other" ) } ) );
+
+    // masks:
+    methods.push_back( make_intrinsic_method( "select",
+                                              new std::vector<TxArgTypeDefNode*>( { new TxArgTypeDefNode( loc, "mask", make_vec_lanes_type( loc, "tx.Bool" ) ),
+                                                                                    new TxArgTypeDefNode( loc, "other", new TxNamedTypeNode( loc, "Self" ) ) } ),
+                                              new TxNamedTypeNode( loc, "Self" ), TXVOP_SELECT, { arg( "mask" ), arg( "other" ) } ) );
+    methods.push_back( make_intrinsic_method( "any", noArgs(), new TxNamedTypeNode( loc, "tx.Bool" ), TXVOP_ANY, { } ) );
+    methods.push_back( make_intrinsic_method( "all", noArgs(), new TxNamedTypeNode( loc, "tx.Bool" ), TXVOP_ALL, { } ) );
+    return methods;
+}
+
+/** Makes a call to the runtime function that flushes the buffered output streams. */
+static TxStatementNode* make_flush_output_stmt( const TxLocation& loc ) {
+    auto flushCallee = new TxFieldValueNode( loc, nullptr, "tx.tx_flush_output" );
+    auto flushCallExpr = new TxFunctionCallNode( loc, flushCallee, new std::vector<TxExpressionNode*>() );
+    return new TxCallStmtNode( loc, flushCallExpr );
+}
+
 static std::vector<TxDeclarationNode*> make_panic_functions( const TxLocation& loc ) {
     std::vector<TxDeclarationNode*> functions;
     { // tx.panic( message : &[]UByte )
@@ -663,7 +821,7 @@ static std::vector<TxDeclarationNode*> make_panic_functions( const TxLocation& l
             auto abortCallExpr = new TxFunctionCallNode( loc, abortCallee, new std::vector<TxExpressionNode*>(), true );
             TxStatementNode* abortStmt = new TxCallStmtNode( loc, abortCallExpr );
 
-            suiteNode = new TxSuiteNode( loc, new std::vector<TxStatementNode*>( { putsStmt, abortStmt } ) );
+            suiteNode = new TxSuiteNode( loc, new std::vector<TxStatementNode*>( { make_flush_output_stmt( loc ), putsStmt, abortStmt } ) );
         }
 
         auto argTypeNode = new TxReferenceTypeNode( loc, nullptr, new TxArrayTypeNode( loc, new TxNamedTypeNode( loc, "tx.UByte" ) ) );
@@ -691,7 +849,7 @@ static std::vector<TxDeclarationNode*> make_panic_functions( const TxLocation& l
             auto abortCallExpr = new TxFunctionCallNode( loc, abortCallee, new std::vector<TxExpressionNode*>(), true );
             TxStatementNode* abortStmt = new TxCallStmtNode( loc, abortCallExpr );
 
-            suiteNode = new TxSuiteNode( loc, new std::vector<TxStatementNode*>( { putsStmt, abortStmt } ) );
+            suiteNode = new TxSuiteNode( loc, new std::vector<TxStatementNode*>( { make_flush_output_stmt( loc ), putsStmt, abortStmt } ) );
         }
 
         auto msgArgTypeNode = new TxReferenceTypeNode( loc, nullptr, new TxArrayTypeNode( loc, new TxNamedTypeNode( loc, "tx.UByte" ) ) );
@@ -860,6 +1018,19 @@ TxParsingUnitNode* BuiltinTypes::createTxModuleAST() {
                 new TxArrayTypeDefNode( loc, new TxNamedTypeNode( loc, "Any" ), arrayMembers ), false, true );
     }
 
+    // create the SIMD vector base type:
+    {
+        auto paramNodes = new std::vector<TxDeclarationNode*>(
+                {
+                  new TxTypeDeclNode( loc, TXD_PUBLIC | TXD_GENPARAM, "E", nullptr, new TxNamedTypeNode( loc, "Elementary" ) ),
+                  new TxFieldDeclNode( loc, TXD_PUBLIC | TXD_GENPARAM,
+                                       new TxNonLocalFieldDefNode( loc, "N", new TxNamedTypeNode( loc, "UInt" ), nullptr ) ),
+                } );
+        this->builtinTypes[TXBT_VECTOR] = new TxTypeDeclNode(
+                loc, TXD_PUBLIC | TXD_BUILTIN, "Vec", paramNodes,
+                new TxVecTypeDefNode( loc, new TxNamedTypeNode( loc, "Elementary" ), make_vec_methods( loc ) ), false, true );
+    }
+
     // create the interface base type:
     {
         // the adaptee type id virtual field member, which is abstract here but concrete in adapter subtypes:
@@ -888,6 +1059,14 @@ TxParsingUnitNode* BuiltinTypes::createTxModuleAST() {
         members->push_back( func );
     }
 
+    {   // declare tx.tx_flush_output, the runtime function that flushes the buffered output streams:
+        auto args = new std::vector<TxArgTypeDefNode*>( { } );
+        members->push_back( new TxFieldDeclNode( loc, TXD_PUBLIC | TXD_EXTERNC | TXD_BUILTIN,
+                                                 new TxNonLocalFieldDefNode( loc, "tx_flush_output",
+                                                                             new TxFunctionTypeNode( loc, false, args, nullptr ),
+                                                                             nullptr ) ) );
+    }
+
     subModules->push_back( this->create_tx_c_module() );
 
     auto module = new TxModuleNode( this->builtinLocation, new TxIdentifier( BUILTIN_NS ),
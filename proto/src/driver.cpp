@@ -382,6 +382,9 @@ int TxDriver::llvm_compile( const std::string& outputFileName ) {
         codegen_errors += this->genContext->generate_code( specNode );
     }
 
+    // generate the initialization of the global/static fields that have non-constant initializers:
+    codegen_errors += this->genContext->generate_static_init();
+
     if ( codegen_errors ) {
         _LOG.error( "- LLVM code generation encountered %d errors", codegen_errors );
         return codegen_errors;
@@ -402,9 +405,19 @@ int TxDriver::llvm_compile( const std::string& outputFileName ) {
                 this->_LOG.debug( "Created program entry for user method %s", funcDecl->get_unique_full_name().c_str() );
         }
     }
+    this->genContext->finalize_debug_info();
     _LOG.info( "+ LLVM code generated (not yet written)" );
 
     this->genContext->initialize_target();
+    if ( int pgoErrors = this->genContext->run_pgo_passes() )
+        return pgoErrors;
+    this->genContext->add_function_attributes();
+
+    if ( this->options.dump_types ) {
+        std::cout << "TYPE LAYOUTS DUMP:\n";
+        this->genContext->print_type_layouts();
+        std::cout << "END TYPE LAYOUTS DUMP\n";
+    }
 
     if ( this->options.dump_ir )
         this->genContext->print_IR();
@@ -421,6 +434,8 @@ int TxDriver::llvm_compile( const std::string& outputFileName ) {
     if ( this->options.run_jit ) {
         if ( !mainGenerated )
             this->_LOG.error( "Can't run program, no main() method found." );
+        else if ( this->options.profile_generate )
+            this->_LOG.warning( "Can't run program instrumented with -fprofile-generate in JIT mode (the LLVM profile runtime isn't linked in)" );
         else {
             this->genContext->run_code();
         }
@@ -30,9 +30,17 @@ public:
     bool dump_ir = false;
     bool run_verifier = false;
     bool run_jit = false;
+    bool jit_profile = false;
     bool no_bc_output = false;
     bool suppress_asserts = false;
     bool allow_tx = false;
+    bool use_gc = false;
+    bool thin_refs = false;
+    bool debug_info = false;
+    bool profile = false;
+    bool profile_generate = false;
+    std::string profileUseFile;
+    bool heap_profile = false;
     std::string txPath;
     std::vector<std::string> sourceSearchPaths;
 };
@@ -0,0 +1,112 @@
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/Support/Dwarf.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#include "util/assert.hpp"
+
+#include "tx_lang_defs.hpp"
+#include "llvm_generator.hpp"
+#include "driver.hpp"
+
+#include "ast/ast_node.hpp"
+#include "symbol/package.hpp"
+#include "symbol/type.hpp"
+
+using namespace llvm;
+
+
+/***** debug info *****/
+
+/* The debug info consists of a DWARF compile unit per source file, a subprogram per generated function,
+ * a source line location per statement, and variable declarations for the arguments and local fields.
+ * Elementary types are described as DWARF base types; other types are only described by name.
+ * Code without a source file (built-in and runtime code) has no debug info.
+ */
+
+static const char* DEBUG_INFO_PRODUCER = "txc";
+
+LlvmGenerationContext::DebugUnit* LlvmGenerationContext::get_debug_unit( const TxNode* node ) {
+    if ( !this->tuplexPackage.driver().get_options().debug_info )
+        return nullptr;
+    auto filename = node->ploc.begin.filename;
+    if ( !filename || filename->empty() )
+        return nullptr;
+
+    auto unitI = this->debugUnits.find( *filename );
+    if ( unitI != this->debugUnits.end() )
+        return &unitI->second;
+
+    if ( this->debugUnits.empty() ) {
+        this->llvmModule().addModuleFlag( Module::Warning, "Debug Info Version", DEBUG_METADATA_VERSION );
+        this->llvmModule().addModuleFlag( Module::Warning, "Dwarf Version", 4 );
+    }
+
+    SmallString<128> directory( sys::path::parent_path( *filename ) );
+    sys::fs::make_absolute( directory );
+    auto basename = sys::path::filename( *filename );
+
+    auto & unit = this->debugUnits[*filename];
+    unit.builder.reset( new DIBuilder( this->llvmModule() ) );
+    // (there is no DWARF language code for Tuplex, C is the closest match for debuggers and profilers)
+    unit.builder->createCompileUnit( dwarf::DW_LANG_C, basename, directory, DEBUG_INFO_PRODUCER, false, "", 0 );
+    unit.file = unit.builder->createFile( basename, directory );
+    return &unit;
+}
+
+DIType* LlvmGenerationContext::get_debug_type( DebugUnit* unit, const TxActualType* acttype ) {
+    auto typeName = acttype->get_declaration()->get_unique_full_name();
+    if ( acttype->get_type_class() == TXTC_ELEMENTARY ) {
+        auto llvmType = this->get_llvm_type( acttype );
+        auto sizeInBits = llvmType->getPrimitiveSizeInBits();
+        unsigned encoding;
+        if ( llvmType->isIntegerTy( 1 ) )
+            encoding = dwarf::DW_ATE_boolean;
+        else if ( is_concrete_floating_type( acttype ) )
+            encoding = dwarf::DW_ATE_float;
+        else if ( is_concrete_uinteger_type( acttype ) )
+            encoding = dwarf::DW_ATE_unsigned;
+        else
+            encoding = dwarf::DW_ATE_signed;
+        return unit->builder->createBasicType( typeName, sizeInBits, sizeInBits, encoding );
+    }
+    return unit->builder->createUnspecifiedType( typeName );
+}
+
+DISubprogram* LlvmGenerationContext::gen_debug_subprogram( const TxNode* node, Function* function, const std::string& name ) {
+    auto unit = this->get_debug_unit( node );
+    if ( !unit )
+        return nullptr;
+    auto line = node->ploc.begin.line;
+    auto subroutineT = unit->builder->createSubroutineType( unit->builder->getOrCreateTypeArray( { } ) );
+    auto subprogram = unit->builder->createFunction( unit->file, name, function->getName(), unit->file, line, subroutineT,
+                                                     function->hasLocalLinkage(), true, line );
+    function->setSubprogram( subprogram );
+    return subprogram;
+}
+
+void LlvmGenerationContext::gen_debug_location( GenScope* scope, const TxNode* node ) {
+    if ( scope->debugScope )
+        scope->builder->SetCurrentDebugLocation( DebugLoc::get( node->ploc.begin.line, node->ploc.begin.column, scope->debugScope ) );
+}
+
+void LlvmGenerationContext::gen_debug_variable( GenScope* scope, const TxNode* node, const std::string& name,
+                                                const TxActualType* acttype, Value* fieldA, unsigned argNo ) {
+    if ( !scope->debugScope )
+        return;
+    auto unit = this->get_debug_unit( node );
+    if ( !unit )
+        return;
+    auto line = node->ploc.begin.line;
+    auto debugType = this->get_debug_type( unit, acttype );
+    auto variable = ( argNo ? unit->builder->createParameterVariable( scope->debugScope, name, argNo, unit->file, line, debugType )
+                            : unit->builder->createAutoVariable( scope->debugScope, name, unit->file, line, debugType ) );
+    unit->builder->insertDeclare( fieldA, variable, unit->builder->createExpression(),
+                                  DebugLoc::get( line, node->ploc.begin.column, scope->debugScope ),
+                                  scope->builder->GetInsertBlock() );
+}
+
+void LlvmGenerationContext::finalize_debug_info() {
+    for ( auto & unitPair : this->debugUnits )
+        unitPair.second.builder->finalize();
+}
@@ -1,12 +1,76 @@
+#include <unistd.h>
+
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/Interpreter.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
 #include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include "llvm_generator.hpp"
+#include "driver.hpp"
+
+#include "symbol/package.hpp"
+#include "symbol/symbol.hpp"
 
 using namespace llvm;
 
+
+/** Returns the readable name of a generated function, i.e. its declaration's unique full name. */
+static std::string demangle_function_name( StringRef symbolName ) {
+    if ( symbolName.endswith( "$func" ) )
+        symbolName = symbolName.drop_back( 5 );
+    return dehashify( symbolName.str() );
+}
+
+/** Writes the symbols of the JIT-compiled functions to the perf map file /tmp/perf-<pid>.map,
+ * which lets perf attribute samples in the JIT-compiled code to the Tuplex functions. */
+class PerfMapJITEventListener : public JITEventListener {
+    std::unique_ptr<raw_fd_ostream> mapFile;
+
+public:
+    PerfMapJITEventListener( Logger* logger ) {
+        auto filename = "/tmp/perf-" + std::to_string( getpid() ) + ".map";
+        std::error_code errorCode;
+        this->mapFile.reset( new raw_fd_ostream( filename, errorCode, sys::fs::F_Text | sys::fs::F_Append ) );
+        if ( errorCode ) {
+            logger->error( "Failed to open perf map file %s: %s", filename.c_str(), errorCode.message().c_str() );
+            this->mapFile.reset();
+        }
+        else
+            logger->info( "Writing JIT symbols to perf map file %s", filename.c_str() );
+    }
+
+    void NotifyObjectEmitted( const object::ObjectFile &obj, const RuntimeDyld::LoadedObjectInfo &loadedInfo ) override {
+        if ( !this->mapFile )
+            return;
+        // the debug object has its section addresses set to where they have been loaded in memory
+        auto debugObj = loadedInfo.getObjectForDebug( obj );
+        if ( !debugObj.getBinary() )
+            return;
+        for ( auto & symbolSize : object::computeSymbolSizes( *debugObj.getBinary() ) ) {
+            auto & symbol = symbolSize.first;
+            if ( symbol.getType() != object::SymbolRef::ST_Function || symbolSize.second == 0 )
+                continue;
+            auto nameOrErr = symbol.getName();
+            if ( !nameOrErr ) {
+                consumeError( nameOrErr.takeError() );
+                continue;
+            }
+            auto addressOrErr = symbol.getAddress();
+            if ( !addressOrErr ) {
+                consumeError( addressOrErr.takeError() );
+                continue;
+            }
+            *this->mapFile << format_hex_no_prefix( *addressOrErr, 1 ) << " " << format_hex_no_prefix( symbolSize.second, 1 )
+                           << " " << demangle_function_name( *nameOrErr ) << "\n";
+        }
+        this->mapFile->flush();
+    }
+};
+
 /* Executes the AST by running the main function */
 int LlvmGenerationContext::run_code() {
     this->LOGGER()->info( "Running code..." );
@@ -25,6 +89,15 @@ int LlvmGenerationContext::run_code() {
         return -1;
     }
 
+    std::unique_ptr<JITEventListener> perfMapListener;
+    if ( this->tuplexPackage.driver().get_options().jit_profile ) {
+        // (the JIT code is registered with GDB, and with perf via the perf map file;
+        //  functions get source line info when compiled with -g)
+        ee->RegisterJITEventListener( JITEventListener::createGDBRegistrationListener() );
+        perfMapListener.reset( new PerfMapJITEventListener( this->LOGGER() ) );
+        ee->RegisterJITEventListener( perfMapListener.get() );
+    }
+
     std::vector<GenericValue> noargs;
     GenericValue v = ee->runFunction( this->entryFunction, noargs );
     int64_t retVal = v.IntVal.getSExtValue();
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <stack>
+#include <set>
 #include <unordered_map>
 #include <typeinfo>
 
@@ -8,8 +9,11 @@
 
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/IR/PassManager.h>
+#include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/IRPrintingPasses.h>
 #include <llvm/Bitcode/ReaderWriter.h>
 #include <llvm/Support/raw_ostream.h>
@@ -18,6 +22,7 @@
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/Instrumentation.h>
 
 #include "util/util.hpp"
 #include "util/assert.hpp"
@@ -25,10 +30,13 @@
 #include "tx_lang_defs.hpp"
 #include "tx_except.hpp"
 #include "llvm_generator.hpp"
+#include "driver.hpp"
 
 #include "ast/ast_modbase.hpp"
 #include "ast/expr/ast_ref.hpp"
 #include "ast/expr/ast_exprs.hpp"
+#include "ast/expr/ast_field.hpp"
+#include "ast/ast_fielddef_node.hpp"
 #include "symbol/package.hpp"
 #include "symbol/symbol_lookup.hpp"
 
@@ -135,6 +143,29 @@ void LlvmGenerationContext::print_IR() {
     std::cout << std::endl;
 }
 
+void LlvmGenerationContext::print_type_layouts() {
+    const DataLayout& dataLayout = this->llvmModule().getDataLayout();
+    printf( "%4s  %6s  %6s  %6s  %s\n", "id", "size", "align", "pad", "type" );
+    for ( auto acttypeI = this->tuplexPackage.registry().runtime_types_cbegin();
+            acttypeI != this->tuplexPackage.registry().data_types_cend();
+            acttypeI++ )
+    {
+        const TxActualType* acttype = *acttypeI;
+        if ( acttype->get_type_class() != TXTC_TUPLE || !acttype->is_static() )
+            continue;
+        auto structT = dyn_cast<StructType>( this->get_llvm_type( acttype ) );
+        if ( !structT || structT->isOpaque() )
+            continue;
+        auto structLayout = dataLayout.getStructLayout( structT );
+        uint64_t fieldsSize = 0;
+        for ( auto elemT : structT->elements() )
+            fieldsSize += dataLayout.getTypeStoreSize( elemT );
+        uint64_t size = structLayout->getSizeInBytes();
+        printf( "%4d  %6lu  %6u  %6lu  %s\n", acttype->get_runtime_type_id(), size, structLayout->getAlignment(),
+                size - fieldsSize, acttype->str( false ).c_str() );
+    }
+}
+
 int LlvmGenerationContext::write_bitcode( const std::string& filepath ) {
     LOG_DEBUG( this->LOGGER(), "Writing LLVM bitcode file '" << filepath << "'" );
     std::error_code errInfo;
@@ -238,6 +269,14 @@ void LlvmGenerationContext::generate_runtime_type_info() {
 
     std::vector<Constant*> supertypeArrays;
 
+    /** reference maps of the data types, used by the garbage collector */
+    bool useGc = this->tuplexPackage.driver().get_options().use_gc;
+    std::vector<Constant*> refMaps;
+
+    /** names of the data types, used by the heap profiler report */
+    bool heapProfile = this->tuplexPackage.driver().get_options().heap_profile;
+    std::vector<Constant*> typeNames;
+
     // create runtime type info for the data types:
     std::vector<Constant*> typeInfos;
     for ( auto acttypeI = this->tuplexPackage.registry().runtime_types_cbegin();
@@ -295,6 +334,11 @@ void LlvmGenerationContext::generate_runtime_type_info() {
         // create the super type id array:
         auto superTypesC = gen_supertype_ids( this, acttype );
         supertypeArrays.push_back( ConstantExpr::getBitCast( superTypesC, superTypesPtrT ) );
+
+        if ( useGc )
+            refMaps.push_back( this->gen_gc_type_refmap( acttype ) );
+        if ( heapProfile )
+            typeNames.push_back( this->gen_const_cstring_chars_address( acttype->str( false ) ) );
     }
 
     // create the vtable meta types for the remaining vtable types:
@@ -360,6 +404,22 @@ void LlvmGenerationContext::generate_runtime_type_info() {
                                                "tx.runtime.SUPER_TYPES" );
         this->register_llvm_value( supertypesC->getName(), supertypesC );
     }
+    if ( useGc ) {
+        auto rmArrayT = ArrayType::get( superTypesPtrT, refMaps.size() );
+        auto rmArrayC = ConstantArray::get( rmArrayT, refMaps );
+        auto refMapsC = new GlobalVariable( this->llvmModule(), rmArrayT, true, GlobalValue::ExternalLinkage,
+                                            rmArrayC,
+                                            "tx.runtime.TYPE_REFMAPS" );
+        this->register_llvm_value( refMapsC->getName(), refMapsC );
+    }
+    if ( heapProfile ) {
+        auto tnArrayT = ArrayType::get( Type::getInt8PtrTy( this->llvmContext ), typeNames.size() );
+        auto tnArrayC = ConstantArray::get( tnArrayT, typeNames );
+        auto typeNamesC = new GlobalVariable( this->llvmModule(), tnArrayT, true, GlobalValue::ExternalLinkage,
+                                              tnArrayC,
+                                              "tx.runtime.TYPE_NAMES" );
+        this->register_llvm_value( typeNamesC->getName(), typeNamesC );
+    }
 }
 
 
@@ -432,27 +492,36 @@ void LlvmGenerationContext::generate_runtime_vtables() {
 
 /***** code generation helpers *****/
 
-llvm::Value* LlvmGenerationContext::gen_malloc( GenScope* scope, llvm::Type* objT ) {
-    auto int32T = Type::getInt32Ty( this->llvmContext );
-    auto mallocParameterType = int32T;
-    auto objSizeC = ConstantExpr::getTruncOrBitCast( ConstantExpr::getSizeOf( objT ), mallocParameterType );
-    auto objCountC = ConstantInt::get( int32T, 1 );
-    auto objAllocI = CallInst::CreateMalloc( scope->builder->GetInsertBlock(), mallocParameterType,
-                                             objT, objSizeC, objCountC, nullptr, "" );
-    scope->builder->GetInsertBlock()->getInstList().push_back( objAllocI );
-    return objAllocI;
+llvm::Value* LlvmGenerationContext::gen_malloc( GenScope* scope, const TxNode* origin, llvm::Type* objT, llvm::Value* typeIdV ) {
+    auto objSizeC = ConstantExpr::getSizeOf( objT );
+    auto objAllocV = this->gen_malloc( scope, origin, objSizeC, typeIdV );
+    return scope->builder->CreatePointerCast( objAllocV, PointerType::getUnqual( objT ) );
 }
 
-llvm::Value* LlvmGenerationContext::gen_malloc( GenScope* scope, Value* sizeV ) {
-    auto int32T = Type::getInt32Ty( this->llvmContext );
-    auto mallocParameterType = int32T;
-    auto objSizeV = scope->builder->CreateTruncOrBitCast( sizeV, mallocParameterType );
-    auto objCountC = ConstantInt::get( int32T, 1 );
-    auto objT = Type::getInt8Ty( this->llvmContext );
-    auto objAllocI = CallInst::CreateMalloc( scope->builder->GetInsertBlock(), mallocParameterType,
-                                             objT, objSizeV, objCountC, nullptr, "" );
-    scope->builder->GetInsertBlock()->getInstList().push_back( objAllocI );
-    return objAllocI;
+/** Marks the result of an allocation call as fresh memory.
+ * (Its dereferenceable size is added by add_function_attributes(), when the target data layout is known.) */
+static CallInst* set_allocation_attributes( CallInst* allocCallI ) {
+    allocCallI->addAttribute( AttributeSet::ReturnIndex, Attribute::NoAlias );
+    return allocCallI;
+}
+
+llvm::Value* LlvmGenerationContext::gen_malloc( GenScope* scope, const TxNode* origin, Value* sizeV, llvm::Value* typeIdV ) {
+    auto objSizeV = scope->builder->CreateZExtOrTrunc( sizeV, Type::getInt64Ty( this->llvmContext ) );
+    if ( this->tuplexPackage.driver().get_options().heap_profile ) {
+        // the profiling hook records the allocation and then allocates as below
+        auto allocFuncA = this->llvmModule().getFunction( "$heapprof_alloc" );
+        ASSERT( allocFuncA, "$heapprof_alloc() function not found in " << this );
+        auto siteC = this->gen_heapprof_site( origin, typeIdV );
+        return set_allocation_attributes( scope->builder->CreateCall( allocFuncA, { objSizeV, typeIdV, siteC } ) );
+    }
+    if ( this->tuplexPackage.driver().get_options().use_gc ) {
+        auto allocFuncA = this->llvmModule().getFunction( "$gc_alloc" );
+        ASSERT( allocFuncA, "$gc_alloc() function not found in " << this );
+        return set_allocation_attributes( scope->builder->CreateCall( allocFuncA, { objSizeV, typeIdV } ) );
+    }
+    auto allocFuncA = this->llvmModule().getFunction( "$dataspace_alloc" );
+    ASSERT( allocFuncA, "$dataspace_alloc() function not found in " << this );
+    return set_allocation_attributes( scope->builder->CreateCall( allocFuncA, { objSizeV } ) );
 }
 
 
@@ -480,7 +549,7 @@ Value* LlvmGenerationContext::gen_get_type_info( GenScope* scope, const TxActual
 
         auto typeInfoLenC = cast<GlobalVariable>( this->lookup_llvm_value( "tx.runtime.TYPE_COUNT" ) );
         auto condV = scope->builder->CreateICmpUGE( runtimeBaseTypeIdV, typeInfoLenC->getInitializer() );
-        scope->builder->CreateCondBr( condV, trueBlock, nextBlock );
+        scope->builder->CreateCondBr( condV, trueBlock, nextBlock, this->get_panic_branch_weights() );
         { // if type id out of bounds (not a data type)
             scope->builder->SetInsertPoint( trueBlock );
             auto indexV = scope->builder->CreateZExt( runtimeBaseTypeIdV, Type::getInt64Ty( this->llvmContext ) );
@@ -495,7 +564,7 @@ Value* LlvmGenerationContext::gen_get_type_info( GenScope* scope, const TxActual
                      runtimeBaseTypeIdV,
                      ConstantInt::get( this->i32T, fieldIndex ) };
     auto valA = scope->builder->CreateInBoundsGEP( typeInfoC, ixs );
-    return scope->builder->CreateLoad( valA );
+    return this->gen_rtti_load( scope, valA );
 }
 
 
@@ -549,7 +618,7 @@ Value* LlvmGenerationContext::gen_get_type_class( GenScope* scope, const TxActua
 
         auto typeClassesLenC = ConstantInt::get( this->i32T, this->tuplexPackage.registry().vtable_types_count() );
         auto condV = scope->builder->CreateICmpUGE( runtimeBaseTypeIdV, typeClassesLenC );
-        scope->builder->CreateCondBr( condV, trueBlock, nextBlock );
+        scope->builder->CreateCondBr( condV, trueBlock, nextBlock, this->get_panic_branch_weights() );
         { // if type id out of bounds (not a vtable type)
             scope->builder->SetInsertPoint( trueBlock );
             auto indexV = scope->builder->CreateZExt( runtimeBaseTypeIdV, Type::getInt64Ty( this->llvmContext ) );
@@ -564,7 +633,7 @@ Value* LlvmGenerationContext::gen_get_type_class( GenScope* scope, const TxActua
     Value* ixs[] = { ConstantInt::get( this->i32T, 0 ),
                      runtimeBaseTypeIdV };
     auto valA = scope->builder->CreateInBoundsGEP( typeClassesC, ixs );
-    return scope->builder->CreateLoad( valA );
+    return this->gen_rtti_load( scope, valA );
 }
 
 
@@ -604,6 +673,12 @@ Constant* LlvmGenerationContext::gen_const_cstring_address( const std::string& v
     return this->gen_const_byte_array_address( array );
 }
 
+Constant* LlvmGenerationContext::gen_const_cstring_chars_address( const std::string& value ) {
+    auto arrayC = this->gen_const_cstring_address( value );
+    Constant* ixs[] = { ConstantInt::get( i32T, 0 ), ConstantInt::get( i32T, 2 ), ConstantInt::get( i32T, 0 ) };
+    return ConstantExpr::getInBoundsGetElementPtr( arrayC->getType()->getPointerElementType(), arrayC, ixs );
+}
+
 Constant* LlvmGenerationContext::gen_const_byte_array_address( const std::vector<uint8_t>& arrayData ) {
     auto iter = this->byteArrayTable.find( arrayData );
     if ( iter != this->byteArrayTable.end() ) {
@@ -650,7 +725,7 @@ Constant* LlvmGenerationContext::gen_const_string_obj_address( StructType* strin
 Value* LlvmGenerationContext::gen_equals_invocation( GenScope* scope, Value* lvalA, Value* lvalTypeIdV, Value* rvalA, Value* rvalTypeIdV ) {
     const TxActualType* anyType = this->tuplexPackage.registry().get_builtin_type( TXBT_ANY )->acttype();
     auto equalsField = anyType->get_virtual_fields().get_field( "equals" );
-    auto methodLambdaV = instance_method_value_code_gen( *this, scope, anyType, lvalTypeIdV, lvalA,
+    auto methodLambdaV = instance_method_value_code_gen( *this, scope, nullptr, anyType, lvalTypeIdV, lvalA,
                                                          equalsField->qualtype()->type()->acttype(), equalsField->get_unique_name(), false );
     auto functionPtrV = gen_get_struct_member( *this, scope, methodLambdaV, 0 );
     auto closureRefV = gen_get_struct_member( *this, scope, methodLambdaV, 1 );
@@ -669,39 +744,65 @@ Value* LlvmGenerationContext::gen_isa( GenScope* scope, Value* refV, Value* type
     return scope->builder->CreateCall( isaFuncC, args, "isa" );
 }
 
-void LlvmGenerationContext::gen_panic_call( GenScope* scope, const std::string& message ) {
-    auto panicSymbol = dynamic_cast<TxEntitySymbol*>( search_symbol( &this->tuplexPackage, "tx.panic" ) );
-    ASSERT( panicSymbol, "Function not found: tx.panic" );
-    for ( auto declI = panicSymbol->fields_cbegin(); declI != panicSymbol->fields_cend(); declI++ ) {
-        auto panicFunc = (*declI)->get_definer()->get_field();
-        auto panicFuncType = dynamic_cast<const TxFunctionType*>( panicFunc->qualtype()->type()->acttype() );
-        if ( panicFuncType->argumentTypes.size() == 1 ) {
-            auto panicLambdaV = panicFunc->code_gen_field_decl( *this );
+/** The branch weights of the edges to and past a panic. (The panic edge is weighted as for a __builtin_expect() miss.) */
+static const uint32_t PANIC_EDGE_WEIGHT = 1;
+static const uint32_t NON_PANIC_EDGE_WEIGHT = 2000;
 
-            auto msgRefType = static_cast<const TxReferenceType*>(panicFuncType->argumentTypes.at( 0 ) );
-            auto msgRefTargTid = msgRefType->target_type()->get_type_id();
-            auto msgRefT = this->get_llvm_type( msgRefType );
-            auto msgPtrC = this->gen_const_cstring_address( message );
-            auto msgRefC = gen_ref( *this, msgRefT, msgPtrC, ConstantInt::get( this->i32T, msgRefTargTid ) );
+MDNode* LlvmGenerationContext::get_panic_branch_weights( bool panicOnTrue ) {
+    auto& weightsMD = this->panicBranchWeights[panicOnTrue ? 0 : 1];
+    if ( !weightsMD ) {
+        MDBuilder mdBuilder( this->llvmContext );
+        weightsMD = panicOnTrue ? mdBuilder.createBranchWeights( PANIC_EDGE_WEIGHT, NON_PANIC_EDGE_WEIGHT )
+                                : mdBuilder.createBranchWeights( NON_PANIC_EDGE_WEIGHT, PANIC_EDGE_WEIGHT );
+    }
+    return weightsMD;
+}
 
-            std::vector<Value*> args( { (Value*)msgRefC } );
-            gen_lambda_call( *this, scope, panicLambdaV, args, "", true );
-            return;
-        }
+Function* LlvmGenerationContext::get_panic_thunk( const std::string& message, Type* argT ) {
+    auto & thunkF = this->panicThunks[std::make_pair( message, argT )];
+    if ( !thunkF ) {
+        auto voidT = Type::getVoidTy( this->llvmContext );
+        auto funcT = ( argT ? FunctionType::get( voidT, { argT }, false ) : FunctionType::get( voidT, false ) );
+        thunkF = Function::Create( funcT, GlobalValue::InternalLinkage, "tx.panic_thunk", &this->llvmModule() );
+        thunkF->addFnAttr( Attribute::Cold );
+        thunkF->addFnAttr( Attribute::NoInline );
+        thunkF->setDoesNotReturn();
+        thunkF->setDoesNotThrow();
     }
-    THROW_LOGIC( "tx.panic() function of proper signature not found" );
+    return thunkF;
+}
+
+void LlvmGenerationContext::gen_panic_call( GenScope* scope, const std::string& message ) {
+    auto thunkF = this->get_panic_thunk( message );
+    if ( thunkF->empty() ) {
+        IRBuilder<> builder( BasicBlock::Create( this->llvmContext, "entry", thunkF ) );
+        GenScope thunkScope( &builder );
+        this->gen_panic_lambda_call( &thunkScope, message, nullptr );
+        builder.CreateUnreachable();
+    }
+    scope->builder->CreateCall( thunkF );
 }
 
 void LlvmGenerationContext::gen_panic_call( GenScope* scope, const std::string& message, Value* ulongValV ) {
+    auto thunkF = this->get_panic_thunk( message, ulongValV->getType() );
+    if ( thunkF->empty() ) {
+        IRBuilder<> builder( BasicBlock::Create( this->llvmContext, "entry", thunkF ) );
+        GenScope thunkScope( &builder );
+        this->gen_panic_lambda_call( &thunkScope, message, &( *thunkF->arg_begin() ) );
+        builder.CreateUnreachable();
+    }
+    scope->builder->CreateCall( thunkF, { ulongValV } );
+}
+
+void LlvmGenerationContext::gen_panic_lambda_call( GenScope* scope, const std::string& message, Value* ulongValV ) {
     auto panicSymbol = dynamic_cast<TxEntitySymbol*>( search_symbol( &this->tuplexPackage, "tx.panic" ) );
     ASSERT( panicSymbol, "Function not found: tx.panic" );
     for ( auto declI = panicSymbol->fields_cbegin(); declI != panicSymbol->fields_cend(); declI++ ) {
         auto panicFunc = (*declI)->get_definer()->get_field();
         auto panicFuncType = dynamic_cast<const TxFunctionType*>( panicFunc->qualtype()->type()->acttype() );
-        if ( panicFuncType->argumentTypes.size() == 2 ) {
+        if ( panicFuncType->argumentTypes.size() == ( ulongValV ? 2 : 1 ) ) {
             auto panicLambdaV = panicFunc->code_gen_field_decl( *this );
 
-            // TODO: make panic statement call the panic function
             // TODO: make creating CString references easier
             auto msgRefType = static_cast<const TxReferenceType*>(panicFuncType->argumentTypes.at( 0 ) );
             auto msgRefTargTid = msgRefType->target_type()->get_type_id();
@@ -709,7 +810,9 @@ void LlvmGenerationContext::gen_panic_call( GenScope* scope, const std::string&
             auto msgPtrC = this->gen_const_cstring_address( message );
             auto msgRefC = gen_ref( *this, msgRefT, msgPtrC, ConstantInt::get( this->i32T, msgRefTargTid ) );
 
-            std::vector<Value*> args( { (Value*)msgRefC, ulongValV } );
+            std::vector<Value*> args( { (Value*)msgRefC } );
+            if ( ulongValV )
+                args.push_back( ulongValV );
             gen_lambda_call( *this, scope, panicLambdaV, args, "", true );
             return;
         }
@@ -748,6 +851,25 @@ Type* LlvmGenerationContext::get_llvm_type( const TxType* txType ) {
     return this->get_llvm_type( txType->acttype() );
 }
 
+StructType* LlvmGenerationContext::get_thin_ref_llvm_type( const TxActualType* targetType, Type* targetLlvmType ) {
+    auto typeId = targetType->get_runtime_type_id();
+    auto iter = this->thinRefTypes.find( typeId );
+    if ( iter != this->thinRefTypes.end() )
+        return iter->second;
+    auto thinRefT = StructType::create( this->llvmContext, { PointerType::getUnqual( targetLlvmType ) },
+                                        targetType->get_declaration()->get_unique_full_name() + "$ref" );
+    this->thinRefTypes.emplace( typeId, thinRefT );
+    this->thinRefTargetTypeIds.emplace( thinRefT, typeId );
+    return thinRefT;
+}
+
+Constant* LlvmGenerationContext::get_thin_ref_typeid( Type* refT ) const {
+    auto iter = this->thinRefTargetTypeIds.find( refT );
+    if ( iter != this->thinRefTargetTypeIds.end() )
+        return ConstantInt::get( this->i32T, iter->second );
+    return nullptr;
+}
+
 Type* LlvmGenerationContext::get_llvm_type( const TxActualType* txType ) {
     ASSERT( txType, "NULL txType provided to getLlvmType()" );
     if ( txType->get_type_class() != TXTC_REFERENCE && txType->is_same_instance_type() )
@@ -779,8 +901,282 @@ Type* LlvmGenerationContext::get_llvm_type( const TxActualType* txType ) {
 }
 
 
+/***** type-based alias analysis metadata *****/
+
+MDNode* LlvmGenerationContext::get_tbaa_access_tag( const std::string& typeNodeName, bool constant ) {
+    auto iter = this->tbaaTags.find( typeNodeName );
+    if ( iter != this->tbaaTags.end() )
+        return iter->second;
+    MDBuilder mdBuilder( this->llvmContext );
+    if ( !this->tbaaRoot )
+        this->tbaaRoot = mdBuilder.createTBAARoot( "tuplex TBAA" );
+    // all type nodes are direct children of the root, i.e. accesses with different tags never alias
+    auto typeNode = mdBuilder.createTBAAScalarTypeNode( typeNodeName, this->tbaaRoot );
+    auto tag = mdBuilder.createTBAAStructTagNode( typeNode, typeNode, 0, constant );
+    this->tbaaTags.emplace( typeNodeName, tag );
+    return tag;
+}
+
+MDNode* LlvmGenerationContext::get_tbaa_tag( const TxActualType* valueType ) {
+    switch ( valueType->get_type_class() ) {
+    case TXTC_ELEMENTARY:
+        if ( auto vecType = dynamic_cast<const TxVectorType*>( valueType ) )
+            return this->get_tbaa_tag( vecType->element_type()->type()->acttype() );
+        if ( !valueType->is_concrete() )
+            return nullptr;
+        return this->get_tbaa_access_tag( "tx." + to_string( this->get_llvm_type( valueType ) ) );
+    case TXTC_REFERENCE:
+        return this->get_tbaa_access_tag( "tx.Ref" );
+    default:
+        // aggregates (tuples, arrays, lambdas) are loaded and stored as a whole, which may alias their members
+        return nullptr;
+    }
+}
+
+MDNode* LlvmGenerationContext::get_tbaa_array_header_tag( unsigned fieldIx ) {
+    ASSERT( fieldIx <= 1, "Invalid array header field index: " << fieldIx );
+    return this->get_tbaa_access_tag( fieldIx == 0 ? "tx.Array.C" : "tx.Array.L" );
+}
+
+LoadInst* LlvmGenerationContext::gen_rtti_load( GenScope* scope, Value* ptrV, const Twine& name ) {
+    auto loadI = scope->builder->CreateLoad( ptrV, name );
+    loadI->setMetadata( LLVMContext::MD_invariant_load, MDNode::get( this->llvmContext, { } ) );
+    return set_tbaa_tag( loadI, this->get_tbaa_access_tag( "tx.RTTI", true ) );
+}
+
+
+/***** function attributes *****/
+
+/** Returns true if the specified pointer refers to the function's own stack allocations. */
+static bool is_local_memory( Value* ptrV ) {
+    return isa<AllocaInst>( ptrV->stripInBoundsOffsets() );
+}
+
+/** Returns true if the specified pointer refers to a constant global. */
+static bool is_constant_memory( Value* ptrV ) {
+    auto globalV = dyn_cast<GlobalVariable>( ptrV->stripInBoundsOffsets() );
+    return ( globalV && globalV->isConstant() );
+}
+
+/** The memory accesses a function performs, apart from accesses to its own stack allocations and to constants. */
+enum MemoryEffect { MEM_NONE, MEM_READ, MEM_WRITE };
+
+static MemoryEffect get_memory_effect( Function& function ) {
+    MemoryEffect effect = MEM_NONE;
+    for ( auto& block : function ) {
+        for ( auto& inst : block ) {
+            if ( auto storeI = dyn_cast<StoreInst>( &inst ) ) {
+                if ( storeI->isVolatile() || !is_local_memory( storeI->getPointerOperand() ) )
+                    return MEM_WRITE;
+            }
+            else if ( auto loadI = dyn_cast<LoadInst>( &inst ) ) {
+                auto ptrV = loadI->getPointerOperand();
+                if ( loadI->isVolatile() )
+                    return MEM_WRITE;
+                if ( !is_local_memory( ptrV ) && !is_constant_memory( ptrV ) )
+                    effect = MEM_READ;
+            }
+            else if ( auto callI = dyn_cast<CallInst>( &inst ) ) {
+                if ( callI->onlyReadsMemory() ) {
+                    if ( !callI->doesNotAccessMemory() )
+                        effect = MEM_READ;
+                }
+                else
+                    return MEM_WRITE;
+            }
+            else if ( inst.mayWriteToMemory() )
+                return MEM_WRITE;
+            else if ( inst.mayReadFromMemory() )
+                effect = MEM_READ;
+        }
+    }
+    return effect;
+}
+
+/** Returns the byte size of a statically sized allocation, or 0 if the size isn't a constant.
+ * Recognizes plain integer constants and the sizeof constant expression, ptrtoint( gep( T* null, 1 ) ). */
+static uint64_t get_static_alloc_size( Value* sizeV, const DataLayout& dataLayout ) {
+    if ( auto sizeC = dyn_cast<ConstantInt>( sizeV ) )
+        return sizeC->getZExtValue();
+    if ( auto sizeCE = dyn_cast<ConstantExpr>( sizeV ) ) {
+        if ( sizeCE->getOpcode() == Instruction::PtrToInt ) {
+            auto gepCE = dyn_cast<ConstantExpr>( sizeCE->getOperand( 0 ) );
+            if ( gepCE && gepCE->getOpcode() == Instruction::GetElementPtr && gepCE->getNumOperands() == 2
+                    && gepCE->getOperand( 0 )->isNullValue() ) {
+                auto countC = dyn_cast<ConstantInt>( gepCE->getOperand( 1 ) );
+                if ( countC && countC->isOne() )
+                    return dataLayout.getTypeAllocSize( gepCE->getOperand( 0 )->getType()->getPointerElementType() );
+            }
+        }
+    }
+    return 0;
+}
+
+void LlvmGenerationContext::add_function_attributes() {
+    auto& dataLayout = this->llvmModule().getDataLayout();
+    auto dsAllocFuncA = this->llvmModule().getFunction( "$dataspace_alloc" );
+    auto gcAllocFuncA = this->llvmModule().getFunction( "$gc_alloc" );
+    auto heapprofAllocFuncA = this->llvmModule().getFunction( "$heapprof_alloc" );
+
+    // Tuplex code never unwinds (panics exit the process):
+    for ( auto& function : this->llvmModule() ) {
+        if ( function.isDeclaration() )
+            continue;
+        function.setDoesNotThrow();
+        for ( auto& block : function ) {
+            for ( auto& inst : block ) {
+                if ( auto callI = dyn_cast<CallInst>( &inst ) ) {
+                    callI->setDoesNotThrow();
+                    auto calleeF = callI->getCalledFunction();
+                    if ( calleeF && ( calleeF == dsAllocFuncA || calleeF == gcAllocFuncA || calleeF == heapprofAllocFuncA ) ) {
+                        if ( auto size = get_static_alloc_size( callI->getArgOperand( 0 ), dataLayout ) )
+                            callI->addDereferenceableOrNullAttr( AttributeSet::ReturnIndex, size );
+                    }
+                }
+            }
+        }
+    }
+
+    // Infer readnone / readonly bottom-up through the call graph, iterating until no more functions qualify.
+    // (This is conservative: functions in recursive cycles are not inferred.)
+    bool changed = true;
+    while ( changed ) {
+        changed = false;
+        for ( auto& function : this->llvmModule() ) {
+            if ( function.isDeclaration() || function.doesNotAccessMemory() )
+                continue;
+            switch ( get_memory_effect( function ) ) {
+            case MEM_NONE:
+                function.removeFnAttr( Attribute::ReadOnly );
+                function.setDoesNotAccessMemory();
+                changed = true;
+                break;
+            case MEM_READ:
+                if ( !function.onlyReadsMemory() ) {
+                    function.setOnlyReadsMemory();
+                    changed = true;
+                }
+                break;
+            case MEM_WRITE:
+                break;
+            }
+        }
+    }
+}
+
+int LlvmGenerationContext::run_pgo_passes() {
+    auto& options = this->tuplexPackage.driver().get_options();
+    if ( !options.profile_generate && options.profileUseFile.empty() )
+        return 0;
+
+    legacy::PassManager passManager;
+    if ( options.profile_generate ) {
+        // the instrumented functions update the profile counters, so no defined function is readnone / readonly:
+        for ( auto& function : this->llvmModule() ) {
+            if ( !function.isDeclaration() ) {
+                function.removeFnAttr( Attribute::ReadNone );
+                function.removeFnAttr( Attribute::ReadOnly );
+            }
+        }
+        // edge counters, and value profiling of the indirect calls (i.e. the lambda calls that aren't resolved statically)
+        passManager.add( createPGOInstrumentationGenLegacyPass() );
+        passManager.add( createInstrProfilingLegacyPass() );
+    }
+    else {
+        if ( !sys::fs::exists( options.profileUseFile ) ) {
+            this->LOGGER()->error( "Profile data file not found: %s", options.profileUseFile.c_str() );
+            return 1;
+        }
+        // attaches the branch weights and the indirect call target profiles,
+        // and promotes the hot indirect call targets to guarded direct calls:
+        passManager.add( createPGOInstrumentationUseLegacyPass( options.profileUseFile ) );
+        passManager.add( createPGOIndirectCallPromotionLegacyPass() );
+    }
+    passManager.run( this->llvmModule() );
+    return 0;
+}
+
+
 /***** main() and other initialization code *****/
 
+void LlvmGenerationContext::add_static_initializer( const TxNonLocalFieldDefNode* fieldDef ) {
+    this->staticInitFields.push_back( fieldDef );
+}
+
+struct StaticInitOrder {
+    std::set<const TxNonLocalFieldDefNode*> initFields;
+    std::map<const TxNonLocalFieldDefNode*, bool> visited;  // false while in progress, true when ordered
+    std::vector<const TxNonLocalFieldDefNode*> ordered;
+    int errors = 0;
+};
+
+/** Adds the field to the initialization order, after the fields with non-constant initializers its initializer refers to. */
+static void order_static_init( const TxNonLocalFieldDefNode* fieldDef, StaticInitOrder* order ) {
+    auto visitedI = order->visited.find( fieldDef );
+    if ( visitedI != order->visited.end() ) {
+        if ( !visitedI->second ) {
+            CERROR( fieldDef, "Recursive dependency between initializers of global/static field " << fieldDef->get_descriptor() );
+            order->errors++;
+        }
+        return;
+    }
+    order->visited[fieldDef] = false;
+
+    std::vector<const TxNonLocalFieldDefNode*> dependencies;
+    auto visitor = []( TxNode* node, const AstCursor& parent, const std::string& role, void* ctx ) {
+        if ( auto fieldNode = dynamic_cast<TxFieldValueNode*>( node ) ) {
+            if ( auto field = fieldNode->get_field() ) {
+                if ( field->get_storage() == TXS_GLOBAL || field->get_storage() == TXS_STATIC ) {
+                    if ( auto depDef = dynamic_cast<const TxNonLocalFieldDefNode*>( field->get_declaration()->get_definer() ) )
+                        static_cast<std::vector<const TxNonLocalFieldDefNode*>*>( ctx )->push_back( depDef );
+                }
+            }
+        }
+    };
+    fieldDef->initExpression->visit_ast( visitor, &dependencies );
+
+    for ( auto depDef : dependencies ) {
+        if ( order->initFields.count( depDef ) )
+            order_static_init( depDef, order );
+    }
+    order->visited[fieldDef] = true;
+    order->ordered.push_back( fieldDef );
+}
+
+int LlvmGenerationContext::generate_static_init() {
+    if ( this->staticInitFields.empty() )
+        return 0;
+
+    StaticInitOrder order;
+    order.initFields.insert( this->staticInitFields.cbegin(), this->staticInitFields.cend() );
+    for ( auto fieldDef : this->staticInitFields )
+        order_static_init( fieldDef, &order );
+    if ( order.errors )
+        return order.errors;
+
+    auto funcT = FunctionType::get( Type::getVoidTy( this->llvmContext ), false );
+    this->staticInitFunction = Function::Create( funcT, GlobalValue::InternalLinkage, "tx.static_init", &this->llvmModule() );
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", this->staticInitFunction );
+    IRBuilder<> builder( entryBlock );
+    GenScope scope( &builder );
+
+    int errors = 0;
+    for ( auto fieldDef : order.ordered ) {
+        LOG_DEBUG( this->LOGGER(), "Generating static initialization of " << fieldDef->get_declaration()->get_unique_full_name() );
+        try {
+            auto initV = fieldDef->initExpression->code_gen_expr( *this, &scope );
+            auto fieldA = fieldDef->get_field()->get_llvm_value();
+            set_tbaa_tag( builder.CreateStore( initV, fieldA ), this->get_tbaa_tag( fieldDef->qualtype()->type()->acttype() ) );
+        }
+        catch ( const codecheck_error& err ) {
+            LOG_DEBUG( this->LOGGER(), "Caught code check error in static initializer of " << fieldDef << ": " << err );
+            errors++;
+        }
+    }
+    builder.CreateRetVoid();
+    return errors;
+}
+
 /** Add main function so can be fully compiled
  * define i32 @main(i32 %argc, i8 **%argv)
  */
@@ -804,10 +1200,26 @@ Function* LlvmGenerationContext::gen_main_function( const std::string userMain,
     }
     BasicBlock *bb = BasicBlock::Create( this->llvmContext, "entry", main_func );
 
-//    // initialize statics / runtime environment
-//    Function *initFunc = this->gen_static_init_function();
-//    CallInst *initCall = CallInst::Create(initFunc, "", bb);
-//    initCall->setTailCall(false);
+    bool useGc = this->tuplexPackage.driver().get_options().use_gc;
+    if ( useGc ) {
+        // the garbage collector scans the stack for roots up to this frame:
+        auto frameAddrF = Intrinsic::getDeclaration( &this->llvmModule(), Intrinsic::frameaddress );
+        auto frameV = CallInst::Create( frameAddrF, { ConstantInt::get( i32T, 0 ) }, "", bb );
+        new StoreInst( frameV, this->lookup_llvm_value( "tx.runtime.GC_STACK_BASE" ), bb );
+    }
+
+    bool profile = this->tuplexPackage.driver().get_options().profile;
+    if ( profile ) {
+        auto cycleCounterF = Intrinsic::getDeclaration( &this->llvmModule(), Intrinsic::readcyclecounter );
+        new StoreInst( CallInst::Create( cycleCounterF, "", bb ), this->lookup_llvm_value( "tx.runtime.PROF_START" ), bb );
+    }
+
+    // initialize the global/static fields with non-constant initializers
+    // (after the runtime environment, since the initializers may allocate):
+    if ( this->staticInitFunction ) {
+        CallInst *initCall = CallInst::Create( this->staticInitFunction, "", bb );
+        initCall->setTailCall( false );
+    }
 
     //call i32 user main()
     auto userMainFName = userMain + "$func";
@@ -818,6 +1230,13 @@ Function* LlvmGenerationContext::gen_main_function( const std::string userMain,
         CallInst *user_main_call = CallInst::Create( func, args, "", bb );
         user_main_call->setTailCall( false );
         user_main_call->setIsNoInline();
+        CallInst::Create( this->llvmModule().getFunction( "tx_flush_output" ), "", bb );
+        if ( useGc )
+            CallInst::Create( this->llvmModule().getFunction( "$gc_report" ), "", bb );
+        if ( profile )
+            CallInst::Create( this->llvmModule().getFunction( "$prof_report" ), "", bb );
+        if ( this->tuplexPackage.driver().get_options().heap_profile )
+            CallInst::Create( this->llvmModule().getFunction( "$heapprof_report" ), "", bb );
         if ( hasIntReturnValue ) {
             // truncate return value to i32
             CastInst* truncVal = CastInst::CreateIntegerCast( user_main_call, i32T, true, "", bb );
@@ -837,6 +1256,14 @@ Function* LlvmGenerationContext::gen_main_function( const std::string userMain,
 
 
 void LlvmGenerationContext::declare_builtin_code() {
+    this->declare_dataspace_runtime();
+    if ( this->tuplexPackage.driver().get_options().use_gc )
+        this->declare_gc_runtime();
+    if ( this->tuplexPackage.driver().get_options().profile )
+        this->declare_profile_runtime();
+    if ( this->tuplexPackage.driver().get_options().heap_profile )
+        this->declare_heapprof_runtime();
+
     StructType* genArrayT = StructType::get( i32T, i32T, ArrayType::get( StructType::get( this->llvmContext ), 0 ), nullptr );
     PointerType* genArrayPtrT = PointerType::getUnqual( genArrayT );
     {
@@ -874,6 +1301,18 @@ void LlvmGenerationContext::generate_builtin_code() {
     this->gen_get_supertypes_array_function();
     this->gen_array_elementary_equals_function();
     this->gen_array_any_equals_function();
+    this->generate_dataspace_runtime();
+    this->generate_float_bits_runtime();
+    this->generate_utf8_runtime();
+    if ( this->tuplexPackage.driver().get_options().use_gc )
+        this->generate_gc_runtime();
+    if ( this->tuplexPackage.driver().get_options().profile )
+        this->generate_profile_runtime();
+    if ( this->tuplexPackage.driver().get_options().heap_profile )
+        this->generate_heapprof_runtime();
+    // (generated last since the code above may trigger generation of the tx.c declarations of stdout / stderr,
+    //  which must precede the stream runtime's references to those globals)
+    this->generate_stream_runtime();
 }
 
 void LlvmGenerationContext::gen_get_supertypes_array_function() {
@@ -914,7 +1353,7 @@ void LlvmGenerationContext::gen_get_supertypes_array_function() {
         {
             builder.SetInsertPoint( nonrefTypeBlock );
             auto refCondV = builder.CreateICmpULT( runtimeBaseTypeIdV, ConstantInt::get( i32T, this->tuplexPackage.registry().func_types_limit() ) );
-            builder.CreateCondBr( refCondV, funcTypeBlock, otherTypeBlock );
+            builder.CreateCondBr( refCondV, funcTypeBlock, otherTypeBlock, this->get_panic_branch_weights( false ) );
         }
         {
             builder.SetInsertPoint( funcTypeBlock );
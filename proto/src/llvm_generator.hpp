@@ -9,6 +9,7 @@
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/ExecutionEngine/GenericValue.h>
 #include <llvm/Support/raw_ostream.h>
 
@@ -16,8 +17,10 @@
 
 #include "symbol/entity_type.hpp"
 
+class TxNode;
 class TxParsingUnitNode;
 class TxTypeDeclNode;
+class TxNonLocalFieldDefNode;
 
 class CompoundStatementScope {
 public:
@@ -38,6 +41,8 @@ class GenScope {
 public:
     llvm::IRBuilder<> * const builder;
     std::stack<CompoundStatementScope*> compStmtStack;
+    /** the debug info scope of the generated function, null if it has no debug info */
+    llvm::DISubprogram* debugScope = nullptr;
 
     GenScope( llvm::IRBuilder<> *builder )
             : entryBlock( builder->GetInsertBlock() ), currentBlock(), builder( builder ) {
@@ -54,11 +59,20 @@ class LlvmGenerationContext {
     Logger& _LOGGER = Logger::get( "LLVMGEN" );
 
     llvm::Function* entryFunction = nullptr;
+    /** the function that initializes the global/static fields with non-constant initializers, if any */
+    llvm::Function* staticInitFunction = nullptr;
+    /** the global/static fields with non-constant initializers, in code generation order */
+    std::vector<const TxNonLocalFieldDefNode*> staticInitFields;
     std::map<const std::string, llvm::Value*> llvmSymbolTable;
     std::map<const TxActualType*, llvm::Type*> llvmTypeMapping;
     std::map<const TxActualType*, llvm::GlobalVariable*> llvmVTables;
     std::map<const TxActualType*, llvm::StructType*> llvmVTableTypes;
 
+    /** thin reference types, keyed by the runtime type id of their (statically exact) target type */
+    std::map<uint32_t, llvm::StructType*> thinRefTypes;
+    /** the target type ids of the thin reference types */
+    std::map<const llvm::Type*, uint32_t> thinRefTargetTypeIds;
+
     /** table of byte array constants (also used for cstrings) to share identical instances */
     std::map<const std::vector<uint8_t>, llvm::Constant*> byteArrayTable;
     /** table of String object constants to share identical instances */
@@ -66,11 +80,45 @@ class LlvmGenerationContext {
 
     std::unique_ptr<llvm::Module> llvmModulePtr;
 
+    /** the root of the TBAA (type-based alias analysis) type tree */
+    llvm::MDNode* tbaaRoot = nullptr;
+    /** the TBAA access tags, keyed by their type node name */
+    std::map<const std::string, llvm::MDNode*> tbaaTags;
+
+    llvm::MDNode* get_tbaa_access_tag( const std::string& typeNodeName, bool constant = false );
+
+    /** the outlined panic functions, keyed by their message and argument type */
+    std::map<std::pair<std::string, llvm::Type*>, llvm::Function*> panicThunks;
+    /** the panic branch weights, for panics on the true and false edges respectively */
+    llvm::MDNode* panicBranchWeights[2] = { nullptr, nullptr };
+
+    void gen_panic_lambda_call( GenScope* scope, const std::string& message, llvm::Value* ulongValV );
+
+    /** A debug info compile unit, one per source file. */
+    struct DebugUnit {
+        std::unique_ptr<llvm::DIBuilder> builder;
+        llvm::DIFile* file;
+    };
+    /** the debug info compile units, keyed by source file name (empty unless debug info is generated) */
+    std::map<const std::string, DebugUnit> debugUnits;
+
+    DebugUnit* get_debug_unit( const TxNode* node );
+    llvm::DIType* get_debug_type( DebugUnit* unit, const TxActualType* acttype );
+
     // some common, basic types:
     llvm::Type* voidPtrT;
     llvm::Type* closureRefT;
     llvm::Type* i32T;
     llvm::PointerType* superTypesPtrT;
+    llvm::StructType* dataspaceT = nullptr;
+    llvm::StructType* gcHeaderT = nullptr;
+    llvm::StructType* outStreamT = nullptr;
+    llvm::StructType* profRecordT = nullptr;
+    llvm::StructType* heapStatT = nullptr;
+
+    /** the profile records of the instrumented functions and virtual dispatch sites (empty unless profiling) */
+    std::vector<llvm::Constant*> profFunctionRecords;
+    std::vector<llvm::Constant*> profSiteRecords;
 
     // simple symbol table for 'internal' llvm values (not in the normal AST symbol table):
     void register_llvm_value( const std::string& identifier, llvm::Value* val );
@@ -86,6 +134,56 @@ class LlvmGenerationContext {
     void gen_array_any_equals_function();
     void gen_array_elementary_equals_function();
 
+    void declare_dataspace_runtime();
+    void generate_dataspace_runtime();
+    void gen_dataspace_alloc_function();
+    void gen_dataspace_create_function();
+    void gen_dataspace_enter_function();
+    void gen_dataspace_leave_function();
+    void gen_dataspace_release_function();
+
+    void generate_float_bits_runtime();
+    void gen_float_bits_function( const std::string& name, llvm::Type* floatT );
+
+    void generate_utf8_runtime();
+    void gen_utf8_validate_function();
+    void gen_utf8_count_function();
+    void gen_utf8_offset_function();
+    void gen_utf8_decode_function();
+
+    void generate_stream_runtime();
+    void gen_stream_flush_function();
+    void gen_stream_write_function();
+    void gen_flush_output_function();
+
+    void declare_gc_runtime();
+    void generate_gc_runtime();
+    void gen_gc_alloc_function();
+    void gen_gc_collect_function();
+    void gen_gc_compare_function();
+    void gen_gc_mark_ptr_function();
+    void gen_gc_mark_stack_function();
+    void gen_gc_trace_function();
+    void gen_gc_report_function();
+    llvm::Constant* gen_gc_type_refmap( const TxActualType* acttype );
+
+    void declare_profile_runtime();
+    void generate_profile_runtime();
+    void gen_profile_compare_function();
+    void gen_profile_report_function();
+    llvm::Constant* gen_profile_record( const std::string& name );
+
+    /** the heap profile records of the allocation sites (empty unless heap profiling) */
+    std::vector<llvm::Constant*> heapprofSiteRecords;
+
+    void declare_heapprof_runtime();
+    void generate_heapprof_runtime();
+    void gen_heapprof_alloc_function();
+    void gen_heapprof_compare_function();
+    void gen_heapprof_report_function();
+    /** Creates the heap profile record of an allocation site. */
+    llvm::Constant* gen_heapprof_site( const TxNode* origin, llvm::Value* typeIdV );
+
 public:
     TxPackage& tuplexPackage;
     llvm::LLVMContext& llvmContext;
@@ -116,8 +214,36 @@ public:
     llvm::Type* get_llvm_type( const TxType* txType );
     llvm::Type* get_llvm_type( const TxActualType* txType );
 
+    /** Gets the thin reference type for the specified statically exact target type.
+     * Thin references consist of only the target pointer, the target type id is constant and known from the reference type. */
+    llvm::StructType* get_thin_ref_llvm_type( const TxActualType* targetType, llvm::Type* targetLlvmType );
+    /** If the specified LLVM type is a thin reference type, returns its target type id, otherwise nullptr. */
+    llvm::Constant* get_thin_ref_typeid( llvm::Type* refT ) const;
+
+    /** Returns the TBAA access tag for loads and stores of values of the specified type,
+     * or nullptr if such accesses aren't tagged (in which case they may alias any other access).
+     * The elementary types are tagged by their machine representation, so that user derivations and aliases
+     * of the same built-in type alias each other; Vec accesses are tagged as accesses of their element type. */
+    llvm::MDNode* get_tbaa_tag( const TxActualType* valueType );
+    /** Returns the TBAA access tag for the array header fields: index 0 is the capacity C, index 1 is the length L. */
+    llvm::MDNode* get_tbaa_array_header_tag( unsigned fieldIx );
+
+    /** Attaches a TBAA access tag to a load or store instruction (does nothing if the tag is null). */
+    template<class InstT>
+    static InstT* set_tbaa_tag( InstT* loadOrStore, llvm::MDNode* tbaaTag ) {
+        if ( tbaaTag )
+            loadOrStore->setMetadata( llvm::LLVMContext::MD_tbaa, tbaaTag );
+        return loadOrStore;
+    }
+
+    /** Generates a load from the runtime type information or a vtable.
+     * These are constant tables, so the load is marked invariant, which allows it to be hoisted and shared freely. */
+    llvm::LoadInst* gen_rtti_load( GenScope* scope, llvm::Value* ptrV, const llvm::Twine& name = "" );
+
     /** Allocates global storage for constant strings, a single shared instance for each unique value. */
     llvm::Constant* gen_const_cstring_address( const std::string& value );
+    /** Returns the address of the character data (an i8 pointer) of the global constant string, for passing to C functions. */
+    llvm::Constant* gen_const_cstring_chars_address( const std::string& value );
     /** Allocates global storage for constant byte arrays, a single shared instance for each unique value. */
     llvm::Constant* gen_const_byte_array_address( const std::vector<uint8_t>& array );
     /** Allocates global storage for constant String objects, a single shared instance for each unique value. */
@@ -125,10 +251,16 @@ public:
 
 
     // "intrinsics":
-    /** Generates a malloc call that allocates storage for the specified LLVM type. */
-    llvm::Value* gen_malloc( GenScope* scope, llvm::Type* objT );
-    /** Generates a malloc call that allocates storage for the specified number of bytes. */
-    llvm::Value* gen_malloc( GenScope* scope, llvm::Value* sizeV );
+    /** Generates a heap allocation of storage for the specified LLVM type, for an object of the specified runtime type id.
+     * The storage is allocated within the current dataspace, or directly on the heap if there is none.
+     * If the garbage collector is enabled, the storage is allocated on the collected heap.
+     * @param origin the node the allocation is generated for (its location identifies the allocation site if heap profiling) */
+    llvm::Value* gen_malloc( GenScope* scope, const TxNode* origin, llvm::Type* objT, llvm::Value* typeIdV );
+    /** Generates a heap allocation of storage for the specified number of bytes, for an object of the specified runtime type id.
+     * The storage is allocated within the current dataspace, or directly on the heap if there is none.
+     * If the garbage collector is enabled, the storage is allocated on the collected heap.
+     * @param origin the node the allocation is generated for (its location identifies the allocation site if heap profiling) */
+    llvm::Value* gen_malloc( GenScope* scope, const TxNode* origin, llvm::Value* sizeV, llvm::Value* typeIdV );
 
     /** Generates a dynamic call to lval.equals(rval) and returns the returned value (a boolean, i1). */
     llvm::Value* gen_equals_invocation( GenScope* scope, llvm::Value* lvalA, llvm::Value* lvalTypeIdV,
@@ -136,9 +268,23 @@ public:
 
     llvm::Value* gen_isa( GenScope* scope, llvm::Value* refV, llvm::Value* typeIdV );
 
+    /** Generates a call to the outlined panic function for the specified message (see get_panic_thunk()).
+     * The message may contain a %d placeholder for the optional ulong value argument. */
     void gen_panic_call( GenScope* scope, const std::string& message );
     void gen_panic_call( GenScope* scope, const std::string& message, llvm::Value* ulongValV );
 
+    /** Gets the outlined panic function ("thunk") for the specified fixed message, creating its declaration if needed.
+     * There is a single, shared thunk per message (and argument type). Thunks are cold, noinline and noreturn,
+     * so that the panic paths are moved out of, and don't burden the code they are reached from.
+     * A newly created thunk has no body, the caller generates it.
+     * @param argT the type of the thunk's single argument, or null if it has no argument */
+    llvm::Function* get_panic_thunk( const std::string& message, llvm::Type* argT = nullptr );
+
+    /** Returns the branch weights (!prof metadata) for a conditional branch with a panic on one of its edges,
+     * marking that edge as very unlikely.
+     * @param panicOnTrue true if the panic is on the branch's true edge, false if on its false edge */
+    llvm::MDNode* get_panic_branch_weights( bool panicOnTrue = true );
+
     llvm::Value* gen_get_vtable( GenScope* scope, const TxActualType* statDeclType, llvm::Value* typeIdV );
 
     /** Generates code that gets the instance/element size for a given type id value.
@@ -168,17 +314,71 @@ public:
 
     void generate_runtime_type_info();
 
+    /** Registers a global/static field whose initializer is not statically constant.
+     * Its storage is zero-initialized and assigned by the static initialization function at program start. */
+    void add_static_initializer( const TxNonLocalFieldDefNode* fieldDef );
+
+    /** Generates the static initialization function, which evaluates the registered non-constant initializers
+     * in dependency order (each field after the fields its initializer refers to).
+     * Must be called after the code for the program has been generated. Returns the number of errors. */
+    int generate_static_init();
+
     void declare_builtin_code();
     void generate_builtin_code();
 
     void generate_runtime_vtables();
 
+    /*--- debug info (generated if the debug_info option is set) ---*/
+
+    /** Creates the debug info subprogram for a function defined by the specified node.
+     * Returns null if debug info isn't generated or the node has no source file (e.g. built-in code). */
+    llvm::DISubprogram* gen_debug_subprogram( const TxNode* node, llvm::Function* function, const std::string& name );
+
+    /** Sets the source location of the subsequently generated instructions to that of the specified node
+     * (does nothing if the function being generated has no debug info). */
+    void gen_debug_location( GenScope* scope, const TxNode* node );
+
+    /** Declares the debug info for a local field or argument, whose storage is the specified (alloca'd) address.
+     * @param argNo the 1-based argument number, or 0 if it is a local field */
+    void gen_debug_variable( GenScope* scope, const TxNode* node, const std::string& name, const TxActualType* acttype,
+                             llvm::Value* fieldA, unsigned argNo = 0 );
+
+    /** Completes the debug info. Must be called after all code has been generated. */
+    void finalize_debug_info();
+
+    /*--- profiling instrumentation (generated if the profile option is set) ---*/
+
+    /** Instruments a generated function with a call counter and entry / exit cycle timestamps, for the flat profile.
+     * Must be called after the function body has been generated. */
+    void gen_profile_function( llvm::Function* function, const std::string& name );
+
+    /** Generates a call count increment for a virtual dispatch site (a method lookup via the vtable). */
+    void gen_profile_dispatch_site( GenScope* scope, const TxNode* origin, const std::string& methodName );
+
+    /** Generates an increment of the passed array bounds checks count. */
+    void gen_profile_bounds_check( GenScope* scope );
+
     /** Create the top level function to call as program entry.
      * (This is the built-in main, which calls the user main function.)  */
     bool generate_main( const std::string& userMainIdent, const TxType* mainFuncType );
 
     void initialize_target();
 
+    /** Adds the function and call attributes that follow from Tuplex semantics to the generated code:
+     * nounwind, readnone / readonly (inferred from the functions' memory accesses), and noalias and
+     * dereferenceable_or_null on allocation results.
+     * Must be called after all code has been generated, and after initialize_target() and run_pgo_passes(). */
+    void add_function_attributes();
+
+    /** Runs the profile-guided optimization passes, if the profile_generate or profileUseFile option is set.
+     * With profile_generate the code is instrumented to write LLVM profile data (edge counters and indirect call
+     * target value profiles; requires linking with the LLVM profile runtime). With profileUseFile the (indexed)
+     * profile data is attached as branch weights, and the hot targets of indirect calls - virtual method and
+     * function value invocations - are promoted to direct calls guarded by a target comparison.
+     * Must be called before add_function_attributes(), since the instrumentation writes to memory.
+     * Returns the number of errors. */
+    int run_pgo_passes();
+
     /** Verfies the generated LLVM code.
      * Should only be used for debugging, may mess with LLVM's state.
      * @return 0 upon success
@@ -188,6 +388,10 @@ public:
     /** Print the LLVM IR in a human-readable format to stdout */
     void print_IR();
 
+    /** Print the instance size and padding of the statically concrete tuple data types to stdout.
+     * Must be called after initialize_target(). */
+    void print_type_layouts();
+
     /** Print the LLVM IR as binary bitcode to a file.
      * @return 0 upon success */
     int write_bitcode( const std::string& filepath );
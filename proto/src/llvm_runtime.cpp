@@ -0,0 +1,2033 @@
+#include <functional>
+#include <sstream>
+
+#include <llvm/IR/Intrinsics.h>
+
+#include "util/assert.hpp"
+
+#include "tx_lang_defs.hpp"
+#include "llvm_generator.hpp"
+#include "driver.hpp"
+
+#include "ast/ast_node.hpp"
+#include "symbol/package.hpp"
+#include "symbol/type_registry.hpp"
+#include "symbol/type.hpp"
+#include "symbol/entity.hpp"
+#include "symbol/qual_type.hpp"
+
+using namespace llvm;
+
+
+/** Gets the C library fprintf function.
+ * (declared independently of the tx.c module since that declares fprintf as non-variadic) */
+static Constant* get_fprintf_function( LlvmGenerationContext& context ) {
+    auto i32T = Type::getInt32Ty( context.llvmContext );
+    auto voidPtrT = context.get_voidPtrT();
+    return context.llvmModule().getOrInsertFunction( "fprintf", FunctionType::get( i32T, { voidPtrT, voidPtrT }, true ) );
+}
+
+/** Creates an alloca'd variable with the specified initial value. */
+static Value* gen_var( IRBuilder<>& builder, Type* varT, Value* initV, const std::string& name ) {
+    auto varA = builder.CreateAlloca( varT, nullptr, name );
+    builder.CreateStore( initV, varA );
+    return varA;
+}
+
+/** Generates code that sorts a table of record pointers with the specified qsort compare function,
+ * and then loops over the records. The table is created as a global with the specified name.
+ * genRecord is invoked to generate the loop body for a record pointer value; it must end by branching to nextBlock.
+ * Afterwards the builder is positioned after the loop. */
+static void gen_sorted_records_loop( LlvmGenerationContext& context, IRBuilder<>& builder, const std::string& tableName,
+                                     PointerType* recordPtrT, const std::vector<Constant*>& records, Function* compareF,
+                                     std::function<void( Value* recordV, BasicBlock* nextBlock )> genRecord ) {
+    auto i64T = Type::getInt64Ty( context.llvmContext );
+    auto voidPtrT = context.get_voidPtrT();
+    auto function = builder.GetInsertBlock()->getParent();
+
+    auto tableT = ArrayType::get( recordPtrT, records.size() );
+    auto tableA = new GlobalVariable( context.llvmModule(), tableT, false, GlobalValue::InternalLinkage,
+                                      ConstantArray::get( tableT, records ), tableName );
+    auto countC = ConstantInt::get( i64T, records.size() );
+    auto tableV = builder.CreateConstInBoundsGEP2_32( tableT, tableA, 0, 0 );
+    auto qsortF = context.llvmModule().getOrInsertFunction( "qsort", Type::getVoidTy( context.llvmContext ),
+                                                            voidPtrT, i64T, i64T, compareF->getType(), NULL );
+    builder.CreateCall( qsortF, { builder.CreatePointerCast( tableV, voidPtrT ), countC, ConstantExpr::getSizeOf( recordPtrT ), compareF } );
+
+    BasicBlock* condBlock   = BasicBlock::Create( context.llvmContext, "cond",   function );
+    BasicBlock* recordBlock = BasicBlock::Create( context.llvmContext, "record", function );
+    BasicBlock* nextBlock   = BasicBlock::Create( context.llvmContext, "next",   function );
+    BasicBlock* endBlock    = BasicBlock::Create( context.llvmContext, "end",    function );
+    auto ixA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "ix" );
+    builder.CreateBr( condBlock );
+
+    builder.SetInsertPoint( condBlock );
+    auto ixV = builder.CreateLoad( ixA );
+    builder.CreateCondBr( builder.CreateICmpULT( ixV, countC ), recordBlock, endBlock );
+
+    builder.SetInsertPoint( recordBlock );
+    genRecord( builder.CreateLoad( builder.CreateInBoundsGEP( tableV, ixV ) ), nextBlock );
+
+    builder.SetInsertPoint( nextBlock );
+    builder.CreateStore( builder.CreateAdd( ixV, ConstantInt::get( i64T, 1 ) ), ixA );
+    builder.CreateBr( condBlock );
+
+    builder.SetInsertPoint( endBlock );
+}
+
+
+/***** dataspace (region) allocator *****/
+
+/* Runtime representation notes:
+ * A dataspace is a heap region consisting of a linked list of chunks. Objects are bump-allocated within
+ * the current chunk; when it is exhausted a new chunk is allocated and linked in. Each chunk begins with
+ * a header holding the pointer to the previous chunk.
+ * Large objects get a dedicated chunk which is linked in behind the current chunk, so that the remaining
+ * space of the current chunk isn't wasted.
+ * Releasing a dataspace frees all of its chunks at once.
+ * A dataspace is flagged as entered from when it's entered until it's left, including while it's shadowed by
+ * a nested dataspace. An entered dataspace can't be entered again nor be released.
+ * When no dataspace is current, allocations are made directly on the global heap (malloc).
+ */
+
+/** size of the dataspace chunk header (the pointer to the previous chunk, padded to keep the allocation alignment) */
+static const uint64_t DS_CHUNK_HEADER_SIZE = 16;
+/** default size of dataspace chunks */
+static const uint64_t DS_CHUNK_SIZE = 64 * 1024;
+/** allocations larger than this get a dedicated chunk */
+static const uint64_t DS_LARGE_OBJECT_SIZE = DS_CHUNK_SIZE / 4;
+/** alignment of all dataspace allocations */
+static const uint64_t DS_ALIGNMENT = 16;
+
+/** field indices of the dataspace struct */
+enum DataspaceField {
+    DS_CHUNK,   // the current chunk
+    DS_CURSOR,  // the next free byte in the current chunk
+    DS_LIMIT,   // the end of the current chunk
+    DS_OUTER,   // the dataspace that was current when this one was entered
+    DS_ENTERED, // true while this dataspace is entered and not left
+};
+
+
+static Value* gen_ds_field_addr( IRBuilder<>& builder, Value* dsPtrV, DataspaceField field ) {
+    return builder.CreateStructGEP( dsPtrV->getType()->getPointerElementType(), dsPtrV, field );
+}
+
+/** Generates a chunk allocation of the specified size, and links it in behind the specified previous chunk. */
+static Value* gen_ds_new_chunk( LlvmGenerationContext& context, IRBuilder<>& builder, Value* chunkSizeV, Value* prevChunkV ) {
+    auto chunkV = builder.CreateCall( context.llvmModule().getFunction( "malloc" ), { chunkSizeV }, "chunk" );
+    auto prevSlotA = builder.CreatePointerCast( chunkV, PointerType::getUnqual( context.get_voidPtrT() ) );
+    builder.CreateStore( prevChunkV, prevSlotA );
+    return chunkV;
+}
+
+
+void LlvmGenerationContext::declare_dataspace_runtime() {
+    auto voidT = Type::getVoidTy( this->llvmContext );
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+
+    this->dataspaceT = StructType::create( this->llvmContext, "tx.runtime.$Dataspace" );
+    auto dataspacePtrT = PointerType::getUnqual( this->dataspaceT );
+    this->dataspaceT->setBody( { this->voidPtrT, this->voidPtrT, this->voidPtrT, dataspacePtrT, Type::getInt1Ty( this->llvmContext ) } );
+
+    auto currentDsC = new GlobalVariable( this->llvmModule(), dataspacePtrT, false, GlobalValue::InternalLinkage,
+                                          ConstantPointerNull::get( dataspacePtrT ),
+                                          "tx.runtime.CURRENT_DATASPACE" );
+    this->register_llvm_value( currentDsC->getName(), currentDsC );
+
+    this->llvmModule().getOrInsertFunction( "malloc", this->voidPtrT, i64T, NULL );
+    this->llvmModule().getOrInsertFunction( "free", voidT, this->voidPtrT, NULL );
+
+    Function* function = cast<Function>( this->llvmModule().getOrInsertFunction(
+            "$dataspace_alloc",
+            this->voidPtrT, // return value - the allocated memory
+            i64T,           // allocation size
+            NULL ) );
+    function->setLinkage( GlobalValue::InternalLinkage );
+}
+
+void LlvmGenerationContext::generate_dataspace_runtime() {
+    this->gen_dataspace_alloc_function();
+    this->gen_dataspace_create_function();
+    this->gen_dataspace_enter_function();
+    this->gen_dataspace_leave_function();
+    this->gen_dataspace_release_function();
+}
+
+/** Gets the runtime function declared by the tx.Dataspace source, or declares it if that source isn't included. */
+static Function* get_dataspace_api_function( LlvmGenerationContext& context, const std::string& name, Type* retT, Type* argT ) {
+    Function* function;
+    if ( argT )
+        function = cast<Function>( context.llvmModule().getOrInsertFunction( name, retT, argT, NULL ) );
+    else
+        function = cast<Function>( context.llvmModule().getOrInsertFunction( name, retT, NULL ) );
+    ASSERT( function->empty(), "Dataspace runtime function already defined: " << name );
+    function->setCallingConv( CallingConv::C );
+    return function;
+}
+
+void LlvmGenerationContext::gen_dataspace_alloc_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    Function* function = this->llvmModule().getFunction( "$dataspace_alloc" );
+    Value* sizeV = &( *function->arg_begin() );
+    sizeV->setName( "size" );
+
+    BasicBlock* entryBlock  = BasicBlock::Create( this->llvmContext, "entry",        function );
+    BasicBlock* heapBlock   = BasicBlock::Create( this->llvmContext, "if_noregion",  function );
+    BasicBlock* regionBlock = BasicBlock::Create( this->llvmContext, "if_region",    function );
+    BasicBlock* bumpBlock   = BasicBlock::Create( this->llvmContext, "if_fits",      function );
+    BasicBlock* nofitBlock  = BasicBlock::Create( this->llvmContext, "if_nofit",     function );
+    BasicBlock* largeBlock  = BasicBlock::Create( this->llvmContext, "if_large",     function );
+    BasicBlock* chunkBlock  = BasicBlock::Create( this->llvmContext, "if_newchunk",  function );
+    IRBuilder<> builder( entryBlock );
+
+    auto mallocFuncA = this->llvmModule().getFunction( "malloc" );
+    auto currentDsA = this->lookup_llvm_value( "tx.runtime.CURRENT_DATASPACE" );
+    auto dsPtrV = builder.CreateLoad( currentDsA, "ds" );
+    builder.CreateCondBr( builder.CreateIsNull( dsPtrV ), heapBlock, regionBlock );
+
+    {   // no current dataspace, allocate on the global heap:
+        builder.SetInsertPoint( heapBlock );
+        builder.CreateRet( builder.CreateCall( mallocFuncA, { sizeV } ) );
+    }
+
+    Value* alignedSizeV;
+    Value* cursorV;
+    {
+        builder.SetInsertPoint( regionBlock );
+        alignedSizeV = builder.CreateAnd( builder.CreateAdd( sizeV, ConstantInt::get( i64T, DS_ALIGNMENT - 1 ) ),
+                                          ConstantInt::get( i64T, ~( DS_ALIGNMENT - 1 ) ), "asize" );
+        cursorV = builder.CreateLoad( gen_ds_field_addr( builder, dsPtrV, DS_CURSOR ), "cursor" );
+        auto limitV = builder.CreateLoad( gen_ds_field_addr( builder, dsPtrV, DS_LIMIT ), "limit" );
+        auto availV = builder.CreateSub( builder.CreatePtrToInt( limitV, i64T ), builder.CreatePtrToInt( cursorV, i64T ), "avail" );
+        builder.CreateCondBr( builder.CreateICmpULE( alignedSizeV, availV ), bumpBlock, nofitBlock );
+    }
+    {   // bump allocation within the current chunk:
+        builder.SetInsertPoint( bumpBlock );
+        builder.CreateStore( builder.CreateInBoundsGEP( cursorV, alignedSizeV ), gen_ds_field_addr( builder, dsPtrV, DS_CURSOR ) );
+        builder.CreateRet( cursorV );
+    }
+    {
+        builder.SetInsertPoint( nofitBlock );
+        auto condV = builder.CreateICmpUGT( alignedSizeV, ConstantInt::get( i64T, DS_LARGE_OBJECT_SIZE ) );
+        builder.CreateCondBr( condV, largeBlock, chunkBlock );
+    }
+    auto headerSizeC = ConstantInt::get( i64T, DS_CHUNK_HEADER_SIZE );
+    {   // dedicated chunk for a large object, linked in behind the current chunk:
+        builder.SetInsertPoint( largeBlock );
+        auto chunkA = gen_ds_field_addr( builder, dsPtrV, DS_CHUNK );
+        auto curChunkV = builder.CreateLoad( chunkA );
+        auto curPrevSlotA = builder.CreatePointerCast( curChunkV, PointerType::getUnqual( this->voidPtrT ) );
+        auto chunkV = gen_ds_new_chunk( *this, builder, builder.CreateAdd( alignedSizeV, headerSizeC ),
+                                        builder.CreateLoad( curPrevSlotA ) );
+        builder.CreateStore( chunkV, curPrevSlotA );
+        builder.CreateRet( builder.CreateInBoundsGEP( chunkV, headerSizeC ) );
+    }
+    {   // replace the current chunk with a new one:
+        builder.SetInsertPoint( chunkBlock );
+        auto chunkA = gen_ds_field_addr( builder, dsPtrV, DS_CHUNK );
+        auto chunkSizeC = ConstantInt::get( i64T, DS_CHUNK_SIZE );
+        auto chunkV = gen_ds_new_chunk( *this, builder, chunkSizeC, builder.CreateLoad( chunkA ) );
+        builder.CreateStore( chunkV, chunkA );
+        auto objV = builder.CreateInBoundsGEP( chunkV, headerSizeC );
+        builder.CreateStore( builder.CreateInBoundsGEP( objV, alignedSizeV ), gen_ds_field_addr( builder, dsPtrV, DS_CURSOR ) );
+        builder.CreateStore( builder.CreateInBoundsGEP( chunkV, chunkSizeC ), gen_ds_field_addr( builder, dsPtrV, DS_LIMIT ) );
+        builder.CreateRet( objV );
+    }
+}
+
+void LlvmGenerationContext::gen_dataspace_create_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    Function* function = get_dataspace_api_function( *this, "tx_dataspace_create", i64T, nullptr );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+
+    auto mallocFuncA = this->llvmModule().getFunction( "malloc" );
+    auto dsSizeC = ConstantExpr::getSizeOf( this->dataspaceT );
+    auto dsPtrV = builder.CreatePointerCast( builder.CreateCall( mallocFuncA, { dsSizeC } ),
+                                             PointerType::getUnqual( this->dataspaceT ), "ds" );
+    auto chunkSizeC = ConstantInt::get( i64T, DS_CHUNK_SIZE );
+    auto chunkV = gen_ds_new_chunk( *this, builder, chunkSizeC, ConstantPointerNull::get( cast<PointerType>( this->voidPtrT ) ) );
+    builder.CreateStore( chunkV, gen_ds_field_addr( builder, dsPtrV, DS_CHUNK ) );
+    builder.CreateStore( builder.CreateInBoundsGEP( chunkV, ConstantInt::get( i64T, DS_CHUNK_HEADER_SIZE ) ),
+                         gen_ds_field_addr( builder, dsPtrV, DS_CURSOR ) );
+    builder.CreateStore( builder.CreateInBoundsGEP( chunkV, chunkSizeC ), gen_ds_field_addr( builder, dsPtrV, DS_LIMIT ) );
+    builder.CreateStore( ConstantPointerNull::get( PointerType::getUnqual( this->dataspaceT ) ),
+                         gen_ds_field_addr( builder, dsPtrV, DS_OUTER ) );
+    builder.CreateStore( ConstantInt::getFalse( this->llvmContext ), gen_ds_field_addr( builder, dsPtrV, DS_ENTERED ) );
+    builder.CreateRet( builder.CreatePtrToInt( dsPtrV, i64T ) );
+}
+
+void LlvmGenerationContext::gen_dataspace_enter_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    Function* function = get_dataspace_api_function( *this, "tx_dataspace_enter", Type::getVoidTy( this->llvmContext ), i64T );
+    Value* handleV = &( *function->arg_begin() );
+    handleV->setName( "handle" );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    BasicBlock* errorBlock = BasicBlock::Create( this->llvmContext, "if_entered", function );
+    BasicBlock* enterBlock = BasicBlock::Create( this->llvmContext, "if_notentered", function );
+    IRBuilder<> builder( entryBlock );
+    GenScope scope( &builder );
+
+    auto currentDsA = this->lookup_llvm_value( "tx.runtime.CURRENT_DATASPACE" );
+    auto dsPtrV = builder.CreateIntToPtr( handleV, PointerType::getUnqual( this->dataspaceT ), "ds" );
+    auto enteredA = gen_ds_field_addr( builder, dsPtrV, DS_ENTERED );
+    builder.CreateCondBr( builder.CreateLoad( enteredA ), errorBlock, enterBlock, this->get_panic_branch_weights() );
+    {
+        builder.SetInsertPoint( errorBlock );
+        this->gen_panic_call( &scope, "Entered a dataspace that is already entered\n" );
+        builder.CreateRetVoid();  // terminate block, though won't be executed
+    }
+    {
+        builder.SetInsertPoint( enterBlock );
+        builder.CreateStore( builder.CreateLoad( currentDsA ), gen_ds_field_addr( builder, dsPtrV, DS_OUTER ) );
+        builder.CreateStore( ConstantInt::getTrue( this->llvmContext ), enteredA );
+        builder.CreateStore( dsPtrV, currentDsA );
+        builder.CreateRetVoid();
+    }
+}
+
+void LlvmGenerationContext::gen_dataspace_leave_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    Function* function = get_dataspace_api_function( *this, "tx_dataspace_leave", Type::getVoidTy( this->llvmContext ), i64T );
+    Value* handleV = &( *function->arg_begin() );
+    handleV->setName( "handle" );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    BasicBlock* errorBlock = BasicBlock::Create( this->llvmContext, "if_notcurrent", function );
+    BasicBlock* leaveBlock = BasicBlock::Create( this->llvmContext, "if_current", function );
+    IRBuilder<> builder( entryBlock );
+    GenScope scope( &builder );
+
+    auto currentDsA = this->lookup_llvm_value( "tx.runtime.CURRENT_DATASPACE" );
+    auto dsPtrV = builder.CreateIntToPtr( handleV, PointerType::getUnqual( this->dataspaceT ), "ds" );
+    builder.CreateCondBr( builder.CreateICmpNE( builder.CreateLoad( currentDsA ), dsPtrV ), errorBlock, leaveBlock,
+                          this->get_panic_branch_weights() );
+    {
+        builder.SetInsertPoint( errorBlock );
+        this->gen_panic_call( &scope, "Left a dataspace that is not the current one\n" );
+        builder.CreateRetVoid();  // terminate block, though won't be executed
+    }
+    {
+        builder.SetInsertPoint( leaveBlock );
+        auto outerA = gen_ds_field_addr( builder, dsPtrV, DS_OUTER );
+        builder.CreateStore( builder.CreateLoad( outerA ), currentDsA );
+        builder.CreateStore( ConstantPointerNull::get( PointerType::getUnqual( this->dataspaceT ) ), outerA );
+        builder.CreateStore( ConstantInt::getFalse( this->llvmContext ), gen_ds_field_addr( builder, dsPtrV, DS_ENTERED ) );
+        builder.CreateRetVoid();
+    }
+}
+
+void LlvmGenerationContext::gen_dataspace_release_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    Function* function = get_dataspace_api_function( *this, "tx_dataspace_release", Type::getVoidTy( this->llvmContext ), i64T );
+    Value* handleV = &( *function->arg_begin() );
+    handleV->setName( "handle" );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    BasicBlock* errorBlock = BasicBlock::Create( this->llvmContext, "if_entered", function );
+    BasicBlock* loopBlock  = BasicBlock::Create( this->llvmContext, "free_chunk", function );
+    BasicBlock* doneBlock  = BasicBlock::Create( this->llvmContext, "free_done", function );
+    IRBuilder<> builder( entryBlock );
+    GenScope scope( &builder );
+
+    auto freeFuncA = this->llvmModule().getFunction( "free" );
+    auto dsPtrV = builder.CreateIntToPtr( handleV, PointerType::getUnqual( this->dataspaceT ), "ds" );
+    auto firstChunkV = builder.CreateLoad( gen_ds_field_addr( builder, dsPtrV, DS_CHUNK ), "chunk" );
+    {   // a dataspace that has been entered and not left (whether current or shadowed) can't be released:
+        auto isEnteredV = builder.CreateLoad( gen_ds_field_addr( builder, dsPtrV, DS_ENTERED ) );
+        builder.CreateCondBr( isEnteredV, errorBlock, loopBlock, this->get_panic_branch_weights() );
+    }
+    {
+        builder.SetInsertPoint( errorBlock );
+        this->gen_panic_call( &scope, "Released a dataspace that has not been left\n" );
+        builder.CreateRetVoid();  // terminate block, though won't be executed
+    }
+    {   // free the chain of chunks (a dataspace always has at least one chunk):
+        builder.SetInsertPoint( loopBlock );
+        auto chunkPhi = builder.CreatePHI( this->voidPtrT, 2, "chunk" );
+        chunkPhi->addIncoming( firstChunkV, entryBlock );
+        auto prevSlotA = builder.CreatePointerCast( chunkPhi, PointerType::getUnqual( this->voidPtrT ) );
+        auto prevChunkV = builder.CreateLoad( prevSlotA, "prev" );
+        builder.CreateCall( freeFuncA, { chunkPhi } );
+        chunkPhi->addIncoming( prevChunkV, loopBlock );
+        builder.CreateCondBr( builder.CreateIsNull( prevChunkV ), doneBlock, loopBlock );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateCall( freeFuncA, { builder.CreatePointerCast( dsPtrV, this->voidPtrT ) } );
+        builder.CreateRetVoid();
+    }
+}
+
+
+/***** buffered output streams *****/
+
+/* Runtime representation notes:
+ * The standard output and error streams each have a statically allocated buffer. Writes are copied into
+ * the buffer, which is written to the C stdio stream when it is full or explicitly flushed.
+ * Writes that don't fit in the (emptied) buffer are written through directly.
+ * The streams are flushed when main() returns and before a panic aborts the program.
+ * Output written directly via the tx.c functions isn't ordered with the buffered output unless the
+ * streams are flushed first.
+ */
+
+/** number of output streams; the stream id is the index (0 = stdout, 1 = stderr) */
+static const unsigned OUT_STREAM_COUNT = 2;
+/** buffer size of each output stream */
+static const uint64_t OUT_STREAM_BUFFER_SIZES[OUT_STREAM_COUNT] = { 64 * 1024, 8 * 1024 };
+/** name of the C stdio stream of each output stream */
+static const char* OUT_STREAM_FILES[OUT_STREAM_COUNT] = { "stdout", "stderr" };
+
+/** field indices of the output stream struct */
+enum OutStreamField {
+    OS_BUFFER,    // the buffer
+    OS_CAPACITY,  // the buffer size
+    OS_LENGTH,    // the number of buffered bytes
+};
+
+
+static Value* gen_os_field_addr( IRBuilder<>& builder, Value* streamPtrV, OutStreamField field ) {
+    return builder.CreateStructGEP( streamPtrV->getType()->getPointerElementType(), streamPtrV, field );
+}
+
+/** Generates the lookup of the C stdio FILE pointer of the specified output stream. */
+static Value* gen_os_file( LlvmGenerationContext& context, IRBuilder<>& builder, Value* streamIdV ) {
+    auto stdoutV = builder.CreateLoad( context.llvmModule().getOrInsertGlobal( OUT_STREAM_FILES[0], context.get_voidPtrT() ) );
+    auto stderrV = builder.CreateLoad( context.llvmModule().getOrInsertGlobal( OUT_STREAM_FILES[1], context.get_voidPtrT() ) );
+    return builder.CreateSelect( builder.CreateIsNull( streamIdV ), stdoutV, stderrV, "file" );
+}
+
+/** Gets the C library fwrite function (possibly declared with a different signature by the tx.c source). */
+static Constant* get_os_fwrite_function( LlvmGenerationContext& context ) {
+    auto i64T = Type::getInt64Ty( context.llvmContext );
+    auto voidPtrT = context.get_voidPtrT();
+    return context.llvmModule().getOrInsertFunction( "fwrite", FunctionType::get( i64T, { voidPtrT, i64T, i64T, voidPtrT }, false ) );
+}
+
+/** Gets the C library fflush function (possibly declared with a different signature by the tx.c source). */
+static Constant* get_os_fflush_function( LlvmGenerationContext& context ) {
+    auto i32T = Type::getInt32Ty( context.llvmContext );
+    return context.llvmModule().getOrInsertFunction( "fflush", FunctionType::get( i32T, { context.get_voidPtrT() }, false ) );
+}
+
+/** Gets the runtime function declared by the tx source, or declares it if that source isn't included. */
+static Function* get_runtime_api_function( LlvmGenerationContext& context, const std::string& name, FunctionType* funcT ) {
+    Function* function = cast<Function>( context.llvmModule().getOrInsertFunction( name, funcT ) );
+    ASSERT( function->empty(), "Runtime function already defined: " << name );
+    function->setCallingConv( CallingConv::C );
+    return function;
+}
+
+
+void LlvmGenerationContext::generate_stream_runtime() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+
+    this->outStreamT = StructType::create( this->llvmContext, "tx.runtime.$OutStream" );
+    this->outStreamT->setBody( { this->voidPtrT, i64T, i64T } );
+
+    std::vector<Constant*> streamCs;
+    for ( unsigned streamId = 0; streamId < OUT_STREAM_COUNT; ++streamId ) {
+        auto bufferT = ArrayType::get( Type::getInt8Ty( this->llvmContext ), OUT_STREAM_BUFFER_SIZES[streamId] );
+        std::string bufferName = std::string( "tx.runtime." ) + OUT_STREAM_FILES[streamId] + "$buffer";
+        auto bufferC = new GlobalVariable( this->llvmModule(), bufferT, false, GlobalValue::InternalLinkage,
+                                           ConstantAggregateZero::get( bufferT ), bufferName );
+        streamCs.push_back( ConstantStruct::get( this->outStreamT, ConstantExpr::getPointerCast( bufferC, this->voidPtrT ),
+                                                 ConstantInt::get( i64T, OUT_STREAM_BUFFER_SIZES[streamId] ),
+                                                 ConstantInt::get( i64T, 0 ), NULL ) );
+    }
+    auto streamsT = ArrayType::get( this->outStreamT, OUT_STREAM_COUNT );
+    auto streamsC = new GlobalVariable( this->llvmModule(), streamsT, false, GlobalValue::InternalLinkage,
+                                        ConstantArray::get( streamsT, streamCs ), "tx.runtime.OUT_STREAMS" );
+    this->register_llvm_value( streamsC->getName(), streamsC );
+
+    this->gen_stream_flush_function();
+    this->gen_stream_write_function();
+    this->gen_flush_output_function();
+}
+
+void LlvmGenerationContext::gen_stream_flush_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto funcT = FunctionType::get( Type::getVoidTy( this->llvmContext ), { i32T }, false );
+    Function* function = get_runtime_api_function( *this, "tx_stream_flush", funcT );
+    Value* streamIdV = &( *function->arg_begin() );
+    streamIdV->setName( "stream" );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry",      function );
+    BasicBlock* writeBlock = BasicBlock::Create( this->llvmContext, "if_pending", function );
+    BasicBlock* doneBlock  = BasicBlock::Create( this->llvmContext, "done",       function );
+    IRBuilder<> builder( entryBlock );
+
+    Value* ixs[] = { ConstantInt::get( i32T, 0 ), streamIdV };
+    auto streamPtrV = builder.CreateInBoundsGEP( this->lookup_llvm_value( "tx.runtime.OUT_STREAMS" ), ixs, "os" );
+    auto lengthA = gen_os_field_addr( builder, streamPtrV, OS_LENGTH );
+    auto lengthV = builder.CreateLoad( lengthA, "length" );
+    auto fileV = gen_os_file( *this, builder, streamIdV );
+    builder.CreateCondBr( builder.CreateIsNull( lengthV ), doneBlock, writeBlock );
+    {
+        builder.SetInsertPoint( writeBlock );
+        auto bufferV = builder.CreateLoad( gen_os_field_addr( builder, streamPtrV, OS_BUFFER ), "buffer" );
+        builder.CreateCall( get_os_fwrite_function( *this ), { bufferV, ConstantInt::get( i64T, 1 ), lengthV, fileV } );
+        builder.CreateStore( ConstantInt::get( i64T, 0 ), lengthA );
+        builder.CreateBr( doneBlock );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateCall( get_os_fflush_function( *this ), { fileV } );
+        builder.CreateRetVoid();
+    }
+}
+
+void LlvmGenerationContext::gen_stream_write_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto funcT = FunctionType::get( Type::getVoidTy( this->llvmContext ), { i32T, this->voidPtrT, i64T }, false );
+    Function* function = get_runtime_api_function( *this, "tx_stream_write", funcT );
+    Function::arg_iterator args = function->arg_begin();
+    Value* streamIdV = &( *args );
+    streamIdV->setName( "stream" );
+    args++;
+    Value* dataV = &( *args );
+    dataV->setName( "data" );
+    args++;
+    Value* sizeV = &( *args );
+    sizeV->setName( "size" );
+
+    BasicBlock* entryBlock   = BasicBlock::Create( this->llvmContext, "entry",      function );
+    BasicBlock* fitsBlock    = BasicBlock::Create( this->llvmContext, "if_fits",    function );
+    BasicBlock* nofitBlock   = BasicBlock::Create( this->llvmContext, "if_nofit",   function );
+    BasicBlock* refillBlock  = BasicBlock::Create( this->llvmContext, "if_small",   function );
+    BasicBlock* throughBlock = BasicBlock::Create( this->llvmContext, "if_large",   function );
+    IRBuilder<> builder( entryBlock );
+
+    Value* ixs[] = { ConstantInt::get( i32T, 0 ), streamIdV };
+    auto streamPtrV = builder.CreateInBoundsGEP( this->lookup_llvm_value( "tx.runtime.OUT_STREAMS" ), ixs, "os" );
+    auto lengthA = gen_os_field_addr( builder, streamPtrV, OS_LENGTH );
+    auto lengthV = builder.CreateLoad( lengthA, "length" );
+    auto capacityV = builder.CreateLoad( gen_os_field_addr( builder, streamPtrV, OS_CAPACITY ), "capacity" );
+    auto bufferV = builder.CreateLoad( gen_os_field_addr( builder, streamPtrV, OS_BUFFER ), "buffer" );
+    auto newLengthV = builder.CreateAdd( lengthV, sizeV, "newlength" );
+    builder.CreateCondBr( builder.CreateICmpULE( newLengthV, capacityV ), fitsBlock, nofitBlock );
+    {   // append to the buffer:
+        builder.SetInsertPoint( fitsBlock );
+        builder.CreateMemCpy( builder.CreateInBoundsGEP( bufferV, lengthV ), dataV, sizeV, 1 );
+        builder.CreateStore( newLengthV, lengthA );
+        builder.CreateRetVoid();
+    }
+    {
+        builder.SetInsertPoint( nofitBlock );
+        builder.CreateCall( this->llvmModule().getFunction( "tx_stream_flush" ), { streamIdV } );
+        builder.CreateCondBr( builder.CreateICmpULT( sizeV, capacityV ), refillBlock, throughBlock );
+    }
+    {   // copy into the emptied buffer:
+        builder.SetInsertPoint( refillBlock );
+        builder.CreateMemCpy( bufferV, dataV, sizeV, 1 );
+        builder.CreateStore( sizeV, lengthA );
+        builder.CreateRetVoid();
+    }
+    {   // bulk data, write through directly:
+        builder.SetInsertPoint( throughBlock );
+        auto fileV = gen_os_file( *this, builder, streamIdV );
+        builder.CreateCall( get_os_fwrite_function( *this ), { dataV, ConstantInt::get( i64T, 1 ), sizeV, fileV } );
+        builder.CreateCall( get_os_fflush_function( *this ), { fileV } );
+        builder.CreateRetVoid();
+    }
+}
+
+void LlvmGenerationContext::gen_flush_output_function() {
+    auto funcT = FunctionType::get( Type::getVoidTy( this->llvmContext ), false );
+    Function* function = get_runtime_api_function( *this, "tx_flush_output", funcT );
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+
+    auto flushF = this->llvmModule().getFunction( "tx_stream_flush" );
+    for ( unsigned streamId = 0; streamId < OUT_STREAM_COUNT; ++streamId )
+        builder.CreateCall( flushF, { ConstantInt::get( i32T, streamId ) } );
+    builder.CreateRetVoid();
+}
+
+
+/***** floating point bits *****/
+
+void LlvmGenerationContext::generate_float_bits_runtime() {
+    this->gen_float_bits_function( "tx_float_bits", Type::getFloatTy( this->llvmContext ) );
+    this->gen_float_bits_function( "tx_double_bits", Type::getDoubleTy( this->llvmContext ) );
+}
+
+/** Generates a function that returns the IEEE bit pattern of a floating point value,
+ * with -0.0 normalized to 0.0 so that values that compare equal get the same bits. */
+void LlvmGenerationContext::gen_float_bits_function( const std::string& name, Type* floatT ) {
+    auto intT = Type::getIntNTy( this->llvmContext, floatT->getPrimitiveSizeInBits() );
+    auto funcT = FunctionType::get( intT, { floatT }, false );
+    Function* function = get_runtime_api_function( *this, name, funcT );
+    function->addFnAttr( Attribute::ReadNone );
+    Value* valueV = &( *function->arg_begin() );
+    valueV->setName( "value" );
+
+    IRBuilder<> builder( BasicBlock::Create( this->llvmContext, "entry", function ) );
+    // (-0.0 + 0.0 is 0.0, while all other values are unchanged by adding 0.0)
+    auto normV = builder.CreateFAdd( valueV, ConstantFP::get( floatT, 0.0 ), "norm" );
+    builder.CreateRet( builder.CreateBitCast( normV, intT, "bits" ) );
+}
+
+
+/***** UTF-8 processing *****/
+
+/* Runtime representation notes:
+ * The UTF-8 functions process the input in 16 byte chunks using vector operations, with a scalar loop
+ * for the remainder and for the non-ASCII sequences that need decoding.
+ * The number of characters in a chunk is the number of bytes that are not continuation bytes (10xxxxxx).
+ * The output array of tx_utf8_decode is passed as a pointer to its elements; its capacity and length
+ * fields precede them (at offsets -8 and -4), and the length is updated.
+ */
+
+/** number of bytes processed per vector chunk */
+static const unsigned UTF8_CHUNK_SIZE = 16;
+/** the replacement character, produced when decoding an invalid sequence */
+static const uint32_t UTF8_REPLACEMENT_CHAR = 0xFFFD;
+
+
+/** Loads the vector chunk at the specified byte index. */
+static Value* gen_utf8_load_chunk( IRBuilder<>& builder, Value* dataV, Value* ixV ) {
+    auto chunkT = VectorType::get( builder.getInt8Ty(), UTF8_CHUNK_SIZE );
+    auto chunkA = builder.CreatePointerCast( builder.CreateInBoundsGEP( dataV, ixV ), PointerType::getUnqual( chunkT ) );
+    return builder.CreateAlignedLoad( chunkA, 1, "chunk" );
+}
+
+/** Returns true if the chunk only contains ASCII bytes. */
+static Value* gen_utf8_chunk_is_ascii( IRBuilder<>& builder, Value* chunkV ) {
+    auto highBitsV = builder.CreateICmpSLT( chunkV, Constant::getNullValue( chunkV->getType() ) );
+    return builder.CreateIsNull( builder.CreateBitCast( highBitsV, builder.getInt16Ty() ), "isascii" );
+}
+
+/** Returns the number (i64) of characters starting in the chunk, i.e. the bytes that are not continuation bytes. */
+static Value* gen_utf8_chunk_char_count( LlvmGenerationContext& context, IRBuilder<>& builder, Value* chunkV ) {
+    auto maskC = ConstantVector::getSplat( UTF8_CHUNK_SIZE, builder.getInt8( 0xC0 ) );
+    auto contC = ConstantVector::getSplat( UTF8_CHUNK_SIZE, builder.getInt8( 0x80 ) );
+    auto isCharV = builder.CreateICmpNE( builder.CreateAnd( chunkV, maskC ), contC );
+    auto ctpopF = Intrinsic::getDeclaration( &context.llvmModule(), Intrinsic::ctpop, { builder.getInt16Ty() } );
+    auto countV = builder.CreateCall( ctpopF, { builder.CreateBitCast( isCharV, builder.getInt16Ty() ) } );
+    return builder.CreateZExt( countV, builder.getInt64Ty(), "count" );
+}
+
+/** Returns true (i1) if the byte is not a continuation byte. */
+static Value* gen_utf8_is_char_start( IRBuilder<>& builder, Value* byteV ) {
+    return builder.CreateICmpNE( builder.CreateAnd( byteV, builder.getInt8( 0xC0 ) ), builder.getInt8( 0x80 ) );
+}
+
+/** Generates the decoding of the UTF-8 sequence starting at the specified index, which must be less than the length.
+ * Valid sequences branch to validBlock with the code point (i32) stored in cpA and the sequence length (i64) in seqLenA.
+ * Invalid sequences (including overlong encodings, surrogates and truncated sequences) branch to invalidBlock.
+ */
+static void gen_utf8_decode_sequence( LlvmGenerationContext& context, IRBuilder<>& builder, Value* dataV, Value* lenV, Value* ixV,
+                                      Value* cpA, Value* seqLenA, BasicBlock* validBlock, BasicBlock* invalidBlock ) {
+    auto function = builder.GetInsertBlock()->getParent();
+    auto i32T = builder.getInt32Ty();
+
+    auto leadV = builder.CreateLoad( builder.CreateInBoundsGEP( dataV, ixV ), "lead" );
+    auto lead32V = builder.CreateZExt( leadV, i32T );
+    auto lt = [&]( unsigned limit ) { return builder.CreateICmpULT( leadV, builder.getInt8( limit ) ); };
+    auto seqLenV = builder.CreateSelect( lt( 0x80 ), builder.getInt64( 1 ),
+                   builder.CreateSelect( lt( 0xE0 ), builder.getInt64( 2 ),
+                   builder.CreateSelect( lt( 0xF0 ), builder.getInt64( 3 ), builder.getInt64( 4 ) ) ), "seqlen" );
+    auto leadMaskV = builder.CreateSelect( lt( 0x80 ), builder.getInt32( 0x7F ),
+                     builder.CreateSelect( lt( 0xE0 ), builder.getInt32( 0x1F ),
+                     builder.CreateSelect( lt( 0xF0 ), builder.getInt32( 0x0F ), builder.getInt32( 0x07 ) ) ) );
+    builder.CreateStore( seqLenV, seqLenA );
+    builder.CreateStore( builder.CreateAnd( lead32V, leadMaskV ), cpA );
+    {   // valid lead bytes are 00..7F and C2..F4, and the sequence must not exceed the input:
+        auto validLeadV = builder.CreateOr( lt( 0x80 ), builder.CreateAnd( builder.CreateICmpUGE( leadV, builder.getInt8( 0xC2 ) ),
+                                                                           builder.CreateICmpULE( leadV, builder.getInt8( 0xF4 ) ) ) );
+        auto withinV = builder.CreateICmpULE( builder.CreateAdd( ixV, seqLenV ), lenV );
+        BasicBlock* nextBlock = BasicBlock::Create( context.llvmContext, "utf8_cont1", function );
+        builder.CreateCondBr( builder.CreateAnd( validLeadV, withinV ), nextBlock, invalidBlock );
+        builder.SetInsertPoint( nextBlock );
+    }
+
+    BasicBlock* checkBlock = BasicBlock::Create( context.llvmContext, "utf8_check", function );
+    for ( unsigned k = 1; k < 4; ++k ) {
+        BasicBlock* readBlock = BasicBlock::Create( context.llvmContext, "utf8_read", function );
+        BasicBlock* addBlock  = BasicBlock::Create( context.llvmContext, "utf8_add",  function );
+        builder.CreateCondBr( builder.CreateICmpULT( builder.getInt64( k ), seqLenV ), readBlock, checkBlock );
+
+        builder.SetInsertPoint( readBlock );
+        auto contV = builder.CreateLoad( builder.CreateInBoundsGEP( dataV, builder.CreateAdd( ixV, builder.getInt64( k ) ) ), "cont" );
+        auto isContV = builder.CreateICmpEQ( builder.CreateAnd( contV, builder.getInt8( 0xC0 ) ), builder.getInt8( 0x80 ) );
+        builder.CreateCondBr( isContV, addBlock, invalidBlock );
+
+        builder.SetInsertPoint( addBlock );
+        auto contBitsV = builder.CreateZExt( builder.CreateAnd( contV, builder.getInt8( 0x3F ) ), i32T );
+        builder.CreateStore( builder.CreateOr( builder.CreateShl( builder.CreateLoad( cpA ), 6 ), contBitsV ), cpA );
+        if ( k == 3 )
+            builder.CreateBr( checkBlock );
+    }
+    {   // reject overlong encodings, surrogates and code points beyond U+10FFFF:
+        builder.SetInsertPoint( checkBlock );
+        auto cpV = builder.CreateLoad( cpA, "cp" );
+        auto minCpV = builder.CreateSelect( builder.CreateICmpEQ( seqLenV, builder.getInt64( 1 ) ), builder.getInt32( 0 ),
+                      builder.CreateSelect( builder.CreateICmpEQ( seqLenV, builder.getInt64( 2 ) ), builder.getInt32( 0x80 ),
+                      builder.CreateSelect( builder.CreateICmpEQ( seqLenV, builder.getInt64( 3 ) ), builder.getInt32( 0x800 ),
+                                            builder.getInt32( 0x10000 ) ) ) );
+        auto isSurrogateV = builder.CreateAnd( builder.CreateICmpUGE( cpV, builder.getInt32( 0xD800 ) ),
+                                               builder.CreateICmpULE( cpV, builder.getInt32( 0xDFFF ) ) );
+        auto validV = builder.CreateAnd( builder.CreateAnd( builder.CreateICmpUGE( cpV, minCpV ),
+                                                            builder.CreateICmpULE( cpV, builder.getInt32( 0x10FFFF ) ) ),
+                                         builder.CreateNot( isSurrogateV ) );
+        builder.CreateCondBr( validV, validBlock, invalidBlock );
+    }
+}
+
+
+void LlvmGenerationContext::generate_utf8_runtime() {
+    this->gen_utf8_validate_function();
+    this->gen_utf8_count_function();
+    this->gen_utf8_offset_function();
+    this->gen_utf8_decode_function();
+}
+
+void LlvmGenerationContext::gen_utf8_validate_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto funcT = FunctionType::get( i64T, { this->voidPtrT, i64T }, false );
+    Function* function = get_runtime_api_function( *this, "tx_utf8_validate", funcT );
+    Function::arg_iterator args = function->arg_begin();
+    Value* dataV = &( *args );
+    dataV->setName( "data" );
+    args++;
+    Value* lenV = &( *args );
+    lenV->setName( "len" );
+
+    BasicBlock* entryBlock      = BasicBlock::Create( this->llvmContext, "entry",        function );
+    BasicBlock* condBlock       = BasicBlock::Create( this->llvmContext, "cond",         function );
+    BasicBlock* chunkBlock      = BasicBlock::Create( this->llvmContext, "chunk",        function );
+    BasicBlock* asciiBlock      = BasicBlock::Create( this->llvmContext, "if_ascii",     function );
+    BasicBlock* scalarCondBlock = BasicBlock::Create( this->llvmContext, "scalar_cond",  function );
+    BasicBlock* seqBlock        = BasicBlock::Create( this->llvmContext, "sequence",     function );
+    BasicBlock* validBlock      = BasicBlock::Create( this->llvmContext, "if_valid",     function );
+    BasicBlock* invalidBlock    = BasicBlock::Create( this->llvmContext, "if_invalid",   function );
+    BasicBlock* doneBlock       = BasicBlock::Create( this->llvmContext, "done",         function );
+    IRBuilder<> builder( entryBlock );
+
+    auto chunkSizeC = ConstantInt::get( i64T, UTF8_CHUNK_SIZE );
+    auto ixA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "ix" );
+    auto cpA = gen_var( builder, i32T, ConstantInt::get( i32T, 0 ), "cp" );
+    auto seqLenA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "seqlen" );
+    builder.CreateBr( condBlock );
+    {
+        builder.SetInsertPoint( condBlock );
+        auto ixV = builder.CreateLoad( ixA );
+        builder.CreateCondBr( builder.CreateICmpULE( builder.CreateAdd( ixV, chunkSizeC ), lenV ), chunkBlock, scalarCondBlock );
+    }
+    {   // whole chunks of ASCII are skipped; otherwise the next sequence is checked:
+        builder.SetInsertPoint( chunkBlock );
+        auto chunkV = gen_utf8_load_chunk( builder, dataV, builder.CreateLoad( ixA ) );
+        builder.CreateCondBr( gen_utf8_chunk_is_ascii( builder, chunkV ), asciiBlock, seqBlock );
+
+        builder.SetInsertPoint( asciiBlock );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( ixA ), chunkSizeC ), ixA );
+        builder.CreateBr( condBlock );
+    }
+    {
+        builder.SetInsertPoint( scalarCondBlock );
+        builder.CreateCondBr( builder.CreateICmpULT( builder.CreateLoad( ixA ), lenV ), seqBlock, doneBlock );
+    }
+    {
+        builder.SetInsertPoint( seqBlock );
+        gen_utf8_decode_sequence( *this, builder, dataV, lenV, builder.CreateLoad( ixA ), cpA, seqLenA, validBlock, invalidBlock );
+
+        builder.SetInsertPoint( validBlock );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( ixA ), builder.CreateLoad( seqLenA ) ), ixA );
+        builder.CreateBr( condBlock );
+    }
+    {
+        builder.SetInsertPoint( invalidBlock );
+        builder.CreateRet( builder.CreateLoad( ixA ) );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateRet( lenV );
+    }
+}
+
+void LlvmGenerationContext::gen_utf8_count_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto funcT = FunctionType::get( i64T, { this->voidPtrT, i64T }, false );
+    Function* function = get_runtime_api_function( *this, "tx_utf8_count", funcT );
+    Function::arg_iterator args = function->arg_begin();
+    Value* dataV = &( *args );
+    dataV->setName( "data" );
+    args++;
+    Value* lenV = &( *args );
+    lenV->setName( "len" );
+
+    BasicBlock* entryBlock      = BasicBlock::Create( this->llvmContext, "entry",        function );
+    BasicBlock* condBlock       = BasicBlock::Create( this->llvmContext, "cond",         function );
+    BasicBlock* chunkBlock      = BasicBlock::Create( this->llvmContext, "chunk",        function );
+    BasicBlock* scalarCondBlock = BasicBlock::Create( this->llvmContext, "scalar_cond",  function );
+    BasicBlock* scalarBlock     = BasicBlock::Create( this->llvmContext, "scalar",       function );
+    BasicBlock* doneBlock       = BasicBlock::Create( this->llvmContext, "done",         function );
+    IRBuilder<> builder( entryBlock );
+
+    auto chunkSizeC = ConstantInt::get( i64T, UTF8_CHUNK_SIZE );
+    auto ixA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "ix" );
+    auto countA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "count" );
+    builder.CreateBr( condBlock );
+    {
+        builder.SetInsertPoint( condBlock );
+        auto ixV = builder.CreateLoad( ixA );
+        builder.CreateCondBr( builder.CreateICmpULE( builder.CreateAdd( ixV, chunkSizeC ), lenV ), chunkBlock, scalarCondBlock );
+    }
+    {
+        builder.SetInsertPoint( chunkBlock );
+        auto ixV = builder.CreateLoad( ixA );
+        auto chunkCountV = gen_utf8_chunk_char_count( *this, builder, gen_utf8_load_chunk( builder, dataV, ixV ) );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( countA ), chunkCountV ), countA );
+        builder.CreateStore( builder.CreateAdd( ixV, chunkSizeC ), ixA );
+        builder.CreateBr( condBlock );
+    }
+    {
+        builder.SetInsertPoint( scalarCondBlock );
+        builder.CreateCondBr( builder.CreateICmpULT( builder.CreateLoad( ixA ), lenV ), scalarBlock, doneBlock );
+    }
+    {
+        builder.SetInsertPoint( scalarBlock );
+        auto ixV = builder.CreateLoad( ixA );
+        auto isCharV = gen_utf8_is_char_start( builder, builder.CreateLoad( builder.CreateInBoundsGEP( dataV, ixV ) ) );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( countA ), builder.CreateZExt( isCharV, i64T ) ), countA );
+        builder.CreateStore( builder.CreateAdd( ixV, ConstantInt::get( i64T, 1 ) ), ixA );
+        builder.CreateBr( scalarCondBlock );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateRet( builder.CreateLoad( countA ) );
+    }
+}
+
+void LlvmGenerationContext::gen_utf8_offset_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto funcT = FunctionType::get( i64T, { this->voidPtrT, i64T, i64T }, false );
+    Function* function = get_runtime_api_function( *this, "tx_utf8_offset", funcT );
+    Function::arg_iterator args = function->arg_begin();
+    Value* dataV = &( *args );
+    dataV->setName( "data" );
+    args++;
+    Value* lenV = &( *args );
+    lenV->setName( "len" );
+    args++;
+    Value* charIxV = &( *args );
+    charIxV->setName( "charix" );
+
+    BasicBlock* entryBlock      = BasicBlock::Create( this->llvmContext, "entry",        function );
+    BasicBlock* condBlock       = BasicBlock::Create( this->llvmContext, "cond",         function );
+    BasicBlock* chunkBlock      = BasicBlock::Create( this->llvmContext, "chunk",        function );
+    BasicBlock* skipBlock       = BasicBlock::Create( this->llvmContext, "if_skip",      function );
+    BasicBlock* scalarCondBlock = BasicBlock::Create( this->llvmContext, "scalar_cond",  function );
+    BasicBlock* scalarBlock     = BasicBlock::Create( this->llvmContext, "scalar",       function );
+    BasicBlock* charBlock       = BasicBlock::Create( this->llvmContext, "if_char",      function );
+    BasicBlock* foundBlock      = BasicBlock::Create( this->llvmContext, "if_found",     function );
+    BasicBlock* nextBlock       = BasicBlock::Create( this->llvmContext, "next",         function );
+    BasicBlock* doneBlock       = BasicBlock::Create( this->llvmContext, "done",         function );
+    IRBuilder<> builder( entryBlock );
+
+    auto chunkSizeC = ConstantInt::get( i64T, UTF8_CHUNK_SIZE );
+    auto oneC = ConstantInt::get( i64T, 1 );
+    auto ixA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "ix" );
+    auto countA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "count" );
+    builder.CreateBr( condBlock );
+    {
+        builder.SetInsertPoint( condBlock );
+        auto ixV = builder.CreateLoad( ixA );
+        builder.CreateCondBr( builder.CreateICmpULE( builder.CreateAdd( ixV, chunkSizeC ), lenV ), chunkBlock, scalarCondBlock );
+    }
+    Value* chunkCountV;
+    {   // skip whole chunks as long as the sought character starts beyond them:
+        builder.SetInsertPoint( chunkBlock );
+        chunkCountV = gen_utf8_chunk_char_count( *this, builder, gen_utf8_load_chunk( builder, dataV, builder.CreateLoad( ixA ) ) );
+        auto newCountV = builder.CreateAdd( builder.CreateLoad( countA ), chunkCountV );
+        builder.CreateCondBr( builder.CreateICmpULE( newCountV, charIxV ), skipBlock, scalarCondBlock );
+
+        builder.SetInsertPoint( skipBlock );
+        builder.CreateStore( newCountV, countA );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( ixA ), chunkSizeC ), ixA );
+        builder.CreateBr( condBlock );
+    }
+    {
+        builder.SetInsertPoint( scalarCondBlock );
+        builder.CreateCondBr( builder.CreateICmpULT( builder.CreateLoad( ixA ), lenV ), scalarBlock, doneBlock );
+    }
+    {
+        builder.SetInsertPoint( scalarBlock );
+        auto byteV = builder.CreateLoad( builder.CreateInBoundsGEP( dataV, builder.CreateLoad( ixA ) ) );
+        builder.CreateCondBr( gen_utf8_is_char_start( builder, byteV ), charBlock, nextBlock );
+
+        builder.SetInsertPoint( charBlock );
+        auto countV = builder.CreateLoad( countA );
+        builder.CreateStore( builder.CreateAdd( countV, oneC ), countA );
+        builder.CreateCondBr( builder.CreateICmpEQ( countV, charIxV ), foundBlock, nextBlock );
+
+        builder.SetInsertPoint( foundBlock );
+        builder.CreateRet( builder.CreateLoad( ixA ) );
+
+        builder.SetInsertPoint( nextBlock );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( ixA ), oneC ), ixA );
+        builder.CreateBr( scalarCondBlock );
+    }
+    {   // the character index is beyond the end:
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateRet( lenV );
+    }
+}
+
+void LlvmGenerationContext::gen_utf8_decode_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto i32PtrT = PointerType::getUnqual( i32T );
+    auto funcT = FunctionType::get( i64T, { this->voidPtrT, i64T, i32PtrT }, false );
+    Function* function = get_runtime_api_function( *this, "tx_utf8_decode", funcT );
+    Function::arg_iterator args = function->arg_begin();
+    Value* dataV = &( *args );
+    dataV->setName( "data" );
+    args++;
+    Value* lenV = &( *args );
+    lenV->setName( "len" );
+    args++;
+    Value* outV = &( *args );
+    outV->setName( "out" );
+
+    BasicBlock* entryBlock      = BasicBlock::Create( this->llvmContext, "entry",        function );
+    BasicBlock* condBlock       = BasicBlock::Create( this->llvmContext, "cond",         function );
+    BasicBlock* chunkBlock      = BasicBlock::Create( this->llvmContext, "chunk",        function );
+    BasicBlock* asciiBlock      = BasicBlock::Create( this->llvmContext, "if_ascii",     function );
+    BasicBlock* scalarCondBlock = BasicBlock::Create( this->llvmContext, "scalar_cond",  function );
+    BasicBlock* seqBlock        = BasicBlock::Create( this->llvmContext, "sequence",     function );
+    BasicBlock* invalidBlock    = BasicBlock::Create( this->llvmContext, "if_invalid",   function );
+    BasicBlock* storeBlock      = BasicBlock::Create( this->llvmContext, "store",        function );
+    BasicBlock* doneBlock       = BasicBlock::Create( this->llvmContext, "done",         function );
+    IRBuilder<> builder( entryBlock );
+
+    auto chunkSizeC = ConstantInt::get( i64T, UTF8_CHUNK_SIZE );
+    auto outCapA = builder.CreateInBoundsGEP( outV, ConstantInt::get( i64T, -2, true ), "outcap" );
+    auto outLenA = builder.CreateInBoundsGEP( outV, ConstantInt::get( i64T, -1, true ), "outlen" );
+    auto outCapV = builder.CreateZExt( builder.CreateLoad( outCapA ), i64T );
+    auto ixA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "ix" );
+    auto outIxA = gen_var( builder, i64T, builder.CreateZExt( builder.CreateLoad( outLenA ), i64T ), "outix" );
+    auto cpA = gen_var( builder, i32T, ConstantInt::get( i32T, 0 ), "cp" );
+    auto seqLenA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "seqlen" );
+    builder.CreateBr( condBlock );
+    {
+        builder.SetInsertPoint( condBlock );
+        auto inFitsV = builder.CreateICmpULE( builder.CreateAdd( builder.CreateLoad( ixA ), chunkSizeC ), lenV );
+        auto outFitsV = builder.CreateICmpULE( builder.CreateAdd( builder.CreateLoad( outIxA ), chunkSizeC ), outCapV );
+        builder.CreateCondBr( builder.CreateAnd( inFitsV, outFitsV ), chunkBlock, scalarCondBlock );
+    }
+    {   // whole chunks of ASCII are widened and stored as a vector; otherwise the next sequence is decoded:
+        builder.SetInsertPoint( chunkBlock );
+        auto chunkV = gen_utf8_load_chunk( builder, dataV, builder.CreateLoad( ixA ) );
+        builder.CreateCondBr( gen_utf8_chunk_is_ascii( builder, chunkV ), asciiBlock, seqBlock );
+
+        builder.SetInsertPoint( asciiBlock );
+        auto outIxV = builder.CreateLoad( outIxA );
+        auto wideT = VectorType::get( i32T, UTF8_CHUNK_SIZE );
+        auto wideA = builder.CreatePointerCast( builder.CreateInBoundsGEP( outV, outIxV ), PointerType::getUnqual( wideT ) );
+        builder.CreateAlignedStore( builder.CreateZExt( chunkV, wideT ), wideA, 4 );
+        builder.CreateStore( builder.CreateAdd( outIxV, chunkSizeC ), outIxA );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( ixA ), chunkSizeC ), ixA );
+        builder.CreateBr( condBlock );
+    }
+    {
+        builder.SetInsertPoint( scalarCondBlock );
+        auto inLeftV = builder.CreateICmpULT( builder.CreateLoad( ixA ), lenV );
+        auto outLeftV = builder.CreateICmpULT( builder.CreateLoad( outIxA ), outCapV );
+        builder.CreateCondBr( builder.CreateAnd( inLeftV, outLeftV ), seqBlock, doneBlock );
+    }
+    {
+        builder.SetInsertPoint( seqBlock );
+        gen_utf8_decode_sequence( *this, builder, dataV, lenV, builder.CreateLoad( ixA ), cpA, seqLenA, storeBlock, invalidBlock );
+
+        builder.SetInsertPoint( invalidBlock );
+        builder.CreateStore( ConstantInt::get( i32T, UTF8_REPLACEMENT_CHAR ), cpA );
+        builder.CreateStore( ConstantInt::get( i64T, 1 ), seqLenA );
+        builder.CreateBr( storeBlock );
+    }
+    {
+        builder.SetInsertPoint( storeBlock );
+        auto outIxV = builder.CreateLoad( outIxA );
+        builder.CreateStore( builder.CreateLoad( cpA ), builder.CreateInBoundsGEP( outV, outIxV ) );
+        builder.CreateStore( builder.CreateAdd( outIxV, ConstantInt::get( i64T, 1 ) ), outIxA );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( ixA ), builder.CreateLoad( seqLenA ) ), ixA );
+        builder.CreateBr( condBlock );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateStore( builder.CreateTrunc( builder.CreateLoad( outIxA ), i32T ), outLenA );
+        builder.CreateRet( builder.CreateLoad( ixA ) );
+    }
+}
+
+
+/***** garbage collector *****/
+
+/* Runtime representation notes:
+ * When compiled with -gc, all heap objects are allocated with a GC header which links them into the heap list
+ * and holds the object's size, runtime type id and mark flag.
+ * Collection is mark-sweep. Objects are traced precisely using the per-type reference offset maps
+ * (tx.runtime.TYPE_REFMAPS, indexed by type id like TYPE_INFOS). For arrays the map describes the element type.
+ * The roots are found by conservatively scanning the stack (from main()'s frame) and the callee-saved registers
+ * (spilled into a jmp_buf via setjmp). This also covers references that only live in SSA temporaries.
+ * Since references may point into objects (e.g. to fields or array elements), a pointer is resolved to its
+ * containing object via a sorted address table built at the start of each collection.
+ */
+
+/** size of the GC object header, keeps the allocation alignment of 16 */
+static const uint64_t GC_HEADER_SIZE = 32;
+/** the heap size that triggers the first collection */
+static const uint64_t GC_MIN_THRESHOLD = 4 * 1024 * 1024;
+/** reference map count value denoting that the type's instances shall be scanned conservatively */
+static const uint32_t GC_CONSERVATIVE_MAP = 0xFFFFFFFF;
+/** initial capacity of the mark stack */
+static const uint64_t GC_MARK_STACK_CAPACITY = 256;
+
+/** field indices of the GC object header */
+enum GcHeaderField {
+    GC_NEXT,    // the next object in the heap list
+    GC_SIZE,    // the object size (excluding header)
+    GC_TYPEID,  // the object's runtime type id
+    GC_MARK,    // the mark flag
+};
+
+static Value* gen_gc_field_addr( IRBuilder<>& builder, Value* headerPtrV, GcHeaderField field ) {
+    return builder.CreateStructGEP( headerPtrV->getType()->getPointerElementType(), headerPtrV, field );
+}
+
+/** Generates code that adds the specified value to an i64 global. */
+static void gen_gc_add_stat( IRBuilder<>& builder, Value* statA, Value* valV ) {
+    builder.CreateStore( builder.CreateAdd( builder.CreateLoad( statA ), valV ), statA );
+}
+
+
+void LlvmGenerationContext::declare_gc_runtime() {
+    auto voidT = Type::getVoidTy( this->llvmContext );
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+
+    this->gcHeaderT = StructType::create( this->llvmContext, "tx.runtime.$GcHeader" );
+    auto headerPtrT = PointerType::getUnqual( this->gcHeaderT );
+    this->gcHeaderT->setBody( { headerPtrT, i64T, i32T, i32T, i64T } );
+
+    auto create_global = [this]( Type* type, Constant* initC, const std::string& name ) {
+        auto globalC = new GlobalVariable( this->llvmModule(), type, false, GlobalValue::InternalLinkage, initC, name );
+        this->register_llvm_value( globalC->getName(), globalC );
+    };
+    auto zeroC = ConstantInt::get( i64T, 0 );
+    create_global( headerPtrT, ConstantPointerNull::get( headerPtrT ), "tx.runtime.GC_HEAP" );
+    create_global( i64T, zeroC, "tx.runtime.GC_OBJECT_COUNT" );
+    create_global( i64T, zeroC, "tx.runtime.GC_HEAP_SIZE" );
+    create_global( i64T, ConstantInt::get( i64T, GC_MIN_THRESHOLD ), "tx.runtime.GC_THRESHOLD" );
+    create_global( this->voidPtrT, ConstantPointerNull::get( cast<PointerType>( this->voidPtrT ) ), "tx.runtime.GC_STACK_BASE" );
+    create_global( PointerType::getUnqual( headerPtrT ), ConstantPointerNull::get( PointerType::getUnqual( headerPtrT ) ),
+                   "tx.runtime.GC_TABLE" );
+    create_global( i64T, zeroC, "tx.runtime.GC_TABLE_SIZE" );
+    create_global( PointerType::getUnqual( headerPtrT ), ConstantPointerNull::get( PointerType::getUnqual( headerPtrT ) ),
+                   "tx.runtime.GC_MARK_STACK" );
+    create_global( i64T, zeroC, "tx.runtime.GC_MARK_STACK_TOP" );
+    create_global( i64T, zeroC, "tx.runtime.GC_MARK_STACK_CAP" );
+    // statistics:
+    create_global( i64T, zeroC, "tx.runtime.GC_COLLECTIONS" );
+    create_global( i64T, zeroC, "tx.runtime.GC_PAUSE_TOTAL" );
+    create_global( i64T, zeroC, "tx.runtime.GC_PAUSE_MAX" );
+    create_global( i64T, zeroC, "tx.runtime.GC_PEAK_SIZE" );
+    create_global( i64T, zeroC, "tx.runtime.GC_FREED_SIZE" );
+
+    this->llvmModule().getOrInsertFunction( "calloc", this->voidPtrT, i64T, i64T, NULL );
+    this->llvmModule().getOrInsertFunction( "realloc", this->voidPtrT, this->voidPtrT, i64T, NULL );
+    this->llvmModule().getOrInsertFunction( "clock", i64T, NULL );
+    auto setjmpF = cast<Function>( this->llvmModule().getOrInsertFunction( "_setjmp", i32T, this->voidPtrT, NULL ) );
+    setjmpF->addFnAttr( Attribute::ReturnsTwice );
+
+    auto declare_function = [this]( const std::string& name, FunctionType* funcT ) {
+        auto function = cast<Function>( this->llvmModule().getOrInsertFunction( name, funcT ) );
+        function->setLinkage( GlobalValue::InternalLinkage );
+        return function;
+    };
+    declare_function( "$gc_alloc",        FunctionType::get( this->voidPtrT, { i64T, i32T }, false ) );
+    declare_function( "$gc_collect",      FunctionType::get( voidT, false ) );
+    declare_function( "$gc_report",       FunctionType::get( voidT, false ) );
+    declare_function( "$gc_compare",      FunctionType::get( i32T, { this->voidPtrT, this->voidPtrT }, false ) );
+    declare_function( "$gc_mark_ptr",     FunctionType::get( voidT, { this->voidPtrT }, false ) );
+    declare_function( "$gc_mark_stack",   FunctionType::get( voidT, false ) )->addFnAttr( Attribute::NoInline );
+    declare_function( "$gc_trace",        FunctionType::get( voidT, false ) );
+}
+
+void LlvmGenerationContext::generate_gc_runtime() {
+    this->gen_gc_alloc_function();
+    this->gen_gc_collect_function();
+    this->gen_gc_compare_function();
+    this->gen_gc_mark_ptr_function();
+    this->gen_gc_mark_stack_function();
+    this->gen_gc_trace_function();
+    this->gen_gc_report_function();
+}
+
+void LlvmGenerationContext::gen_gc_alloc_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    Function* function = this->llvmModule().getFunction( "$gc_alloc" );
+    Function::arg_iterator args = function->arg_begin();
+    Value* sizeV = &( *args );
+    sizeV->setName( "size" );
+    args++;
+    Value* typeIdV = &( *args );
+    typeIdV->setName( "typeId" );
+
+    BasicBlock* entryBlock   = BasicBlock::Create( this->llvmContext, "entry",      function );
+    BasicBlock* collectBlock = BasicBlock::Create( this->llvmContext, "if_collect", function );
+    BasicBlock* allocBlock   = BasicBlock::Create( this->llvmContext, "alloc",      function );
+    IRBuilder<> builder( entryBlock );
+
+    auto heapSizeA = this->lookup_llvm_value( "tx.runtime.GC_HEAP_SIZE" );
+    {
+        auto newSizeV = builder.CreateAdd( builder.CreateLoad( heapSizeA ), sizeV );
+        auto thresholdV = builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.GC_THRESHOLD" ) );
+        builder.CreateCondBr( builder.CreateICmpUGT( newSizeV, thresholdV ), collectBlock, allocBlock );
+    }
+    {
+        builder.SetInsertPoint( collectBlock );
+        builder.CreateCall( this->llvmModule().getFunction( "$gc_collect" ) );
+        builder.CreateBr( allocBlock );
+    }
+    {
+        builder.SetInsertPoint( allocBlock );
+        // calloc so that not yet initialized reference fields are null when traced
+        auto allocV = builder.CreateCall( this->llvmModule().getFunction( "calloc" ),
+                                          { ConstantInt::get( i64T, 1 ), builder.CreateAdd( sizeV, ConstantInt::get( i64T, GC_HEADER_SIZE ) ) } );
+        auto headerV = builder.CreatePointerCast( allocV, PointerType::getUnqual( this->gcHeaderT ), "header" );
+        auto heapA = this->lookup_llvm_value( "tx.runtime.GC_HEAP" );
+        builder.CreateStore( builder.CreateLoad( heapA ), gen_gc_field_addr( builder, headerV, GC_NEXT ) );
+        builder.CreateStore( headerV, heapA );
+        builder.CreateStore( sizeV, gen_gc_field_addr( builder, headerV, GC_SIZE ) );
+        builder.CreateStore( typeIdV, gen_gc_field_addr( builder, headerV, GC_TYPEID ) );
+
+        gen_gc_add_stat( builder, this->lookup_llvm_value( "tx.runtime.GC_OBJECT_COUNT" ), ConstantInt::get( i64T, 1 ) );
+        gen_gc_add_stat( builder, heapSizeA, sizeV );
+        auto peakSizeA = this->lookup_llvm_value( "tx.runtime.GC_PEAK_SIZE" );
+        auto heapSizeV = builder.CreateLoad( heapSizeA );
+        auto peakSizeV = builder.CreateLoad( peakSizeA );
+        builder.CreateStore( builder.CreateSelect( builder.CreateICmpUGT( heapSizeV, peakSizeV ), heapSizeV, peakSizeV ), peakSizeA );
+
+        builder.CreateRet( builder.CreateInBoundsGEP( allocV, ConstantInt::get( i64T, GC_HEADER_SIZE ) ) );
+    }
+}
+
+void LlvmGenerationContext::gen_gc_collect_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto headerPtrT = PointerType::getUnqual( this->gcHeaderT );
+    Function* function = this->llvmModule().getFunction( "$gc_collect" );
+
+    BasicBlock* entryBlock     = BasicBlock::Create( this->llvmContext, "entry",       function );
+    BasicBlock* tableCondBlock = BasicBlock::Create( this->llvmContext, "table_cond",  function );
+    BasicBlock* tableBlock     = BasicBlock::Create( this->llvmContext, "table_add",   function );
+    BasicBlock* markBlock      = BasicBlock::Create( this->llvmContext, "mark",        function );
+    BasicBlock* sweepCondBlock = BasicBlock::Create( this->llvmContext, "sweep_cond",  function );
+    BasicBlock* sweepBlock     = BasicBlock::Create( this->llvmContext, "sweep",       function );
+    BasicBlock* liveBlock      = BasicBlock::Create( this->llvmContext, "if_live",     function );
+    BasicBlock* deadBlock      = BasicBlock::Create( this->llvmContext, "if_dead",     function );
+    BasicBlock* doneBlock      = BasicBlock::Create( this->llvmContext, "done",        function );
+    IRBuilder<> builder( entryBlock );
+
+    auto clockFuncA = this->llvmModule().getFunction( "clock" );
+    auto mallocFuncA = this->llvmModule().getFunction( "malloc" );
+    auto freeFuncA = this->llvmModule().getFunction( "free" );
+    auto heapA = this->lookup_llvm_value( "tx.runtime.GC_HEAP" );
+    auto tableA = this->lookup_llvm_value( "tx.runtime.GC_TABLE" );
+    auto objCountA = this->lookup_llvm_value( "tx.runtime.GC_OBJECT_COUNT" );
+    auto heapSizeA = this->lookup_llvm_value( "tx.runtime.GC_HEAP_SIZE" );
+
+    auto startTimeV = builder.CreateCall( clockFuncA, {}, "start" );
+
+    // spill the callee-saved registers onto the stack so that they are scanned as roots:
+    auto jmpBufA = builder.CreateAlloca( ArrayType::get( i64T, 64 ), nullptr, "jmpbuf" );
+    builder.CreateCall( this->llvmModule().getFunction( "_setjmp" ), { builder.CreatePointerCast( jmpBufA, this->voidPtrT ) } );
+
+    // build the sorted address table of the heap objects:
+    auto objCountV = builder.CreateLoad( objCountA, "count" );
+    auto tableSizeV = builder.CreateMul( objCountV, ConstantExpr::getSizeOf( headerPtrT ) );
+    auto tableV = builder.CreatePointerCast( builder.CreateCall( mallocFuncA, { tableSizeV } ), PointerType::getUnqual( headerPtrT ) );
+    builder.CreateStore( tableV, tableA );
+    builder.CreateStore( objCountV, this->lookup_llvm_value( "tx.runtime.GC_TABLE_SIZE" ) );
+    auto ixA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "ix" );
+    auto headerA = gen_var( builder, headerPtrT, builder.CreateLoad( heapA ), "header" );
+    builder.CreateBr( tableCondBlock );
+    Value* prevA;
+    {
+        builder.SetInsertPoint( tableCondBlock );
+        builder.CreateCondBr( builder.CreateIsNull( builder.CreateLoad( headerA ) ), markBlock, tableBlock );
+    }
+    {
+        builder.SetInsertPoint( tableBlock );
+        auto headerV = builder.CreateLoad( headerA );
+        auto ixV = builder.CreateLoad( ixA );
+        builder.CreateStore( headerV, builder.CreateInBoundsGEP( tableV, ixV ) );
+        builder.CreateStore( builder.CreateAdd( ixV, ConstantInt::get( i64T, 1 ) ), ixA );
+        builder.CreateStore( builder.CreateLoad( gen_gc_field_addr( builder, headerV, GC_NEXT ) ), headerA );
+        builder.CreateBr( tableCondBlock );
+    }
+    {
+        builder.SetInsertPoint( markBlock );
+        auto compareF = this->llvmModule().getFunction( "$gc_compare" );
+        auto qsortF = this->llvmModule().getOrInsertFunction( "qsort", Type::getVoidTy( this->llvmContext ),
+                                                              this->voidPtrT, i64T, i64T, compareF->getType(), NULL );
+        builder.CreateCall( qsortF, { builder.CreatePointerCast( tableV, this->voidPtrT ), objCountV,
+                                      ConstantExpr::getSizeOf( headerPtrT ), compareF } );
+
+        auto markStackCapC = ConstantInt::get( i64T, GC_MARK_STACK_CAPACITY );
+        auto markStackV = builder.CreateCall( mallocFuncA, { ConstantExpr::getMul( markStackCapC, ConstantExpr::getSizeOf( headerPtrT ) ) } );
+        builder.CreateStore( builder.CreatePointerCast( markStackV, PointerType::getUnqual( headerPtrT ) ),
+                             this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK" ) );
+        builder.CreateStore( markStackCapC, this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK_CAP" ) );
+        builder.CreateStore( ConstantInt::get( i64T, 0 ), this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK_TOP" ) );
+
+        builder.CreateCall( this->llvmModule().getFunction( "$gc_mark_stack" ) );
+        builder.CreateCall( this->llvmModule().getFunction( "$gc_trace" ) );
+
+        builder.CreateCall( freeFuncA, { markStackV } );
+        builder.CreateCall( freeFuncA, { builder.CreatePointerCast( tableV, this->voidPtrT ) } );
+        builder.CreateStore( ConstantPointerNull::get( PointerType::getUnqual( headerPtrT ) ), tableA );
+
+        // sweep; prevA holds the address of the link to the current object:
+        builder.CreateStore( builder.CreateLoad( heapA ), headerA );
+        prevA = gen_var( builder, PointerType::getUnqual( headerPtrT ), heapA, "prev" );
+        builder.CreateBr( sweepCondBlock );
+    }
+    {
+        builder.SetInsertPoint( sweepCondBlock );
+        builder.CreateCondBr( builder.CreateIsNull( builder.CreateLoad( headerA ) ), doneBlock, sweepBlock );
+    }
+    Value* headerV;
+    Value* nextV;
+    {
+        builder.SetInsertPoint( sweepBlock );
+        headerV = builder.CreateLoad( headerA );
+        nextV = builder.CreateLoad( gen_gc_field_addr( builder, headerV, GC_NEXT ) );
+        builder.CreateStore( nextV, headerA );
+        auto markA = gen_gc_field_addr( builder, headerV, GC_MARK );
+        builder.CreateCondBr( builder.CreateIsNotNull( builder.CreateLoad( markA ) ), liveBlock, deadBlock );
+
+        builder.SetInsertPoint( liveBlock );
+        builder.CreateStore( ConstantInt::get( i32T, 0 ), markA );
+        builder.CreateStore( gen_gc_field_addr( builder, headerV, GC_NEXT ), prevA );
+        builder.CreateBr( sweepCondBlock );
+    }
+    {
+        builder.SetInsertPoint( deadBlock );
+        builder.CreateStore( nextV, builder.CreateLoad( prevA ) );
+        auto sizeV = builder.CreateLoad( gen_gc_field_addr( builder, headerV, GC_SIZE ) );
+        gen_gc_add_stat( builder, heapSizeA, builder.CreateNeg( sizeV ) );
+        gen_gc_add_stat( builder, objCountA, ConstantInt::get( i64T, -1, true ) );
+        gen_gc_add_stat( builder, this->lookup_llvm_value( "tx.runtime.GC_FREED_SIZE" ), sizeV );
+        builder.CreateCall( freeFuncA, { builder.CreatePointerCast( headerV, this->voidPtrT ) } );
+        builder.CreateBr( sweepCondBlock );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        // next collection when the heap has doubled in size since this one:
+        auto liveSizeV = builder.CreateShl( builder.CreateLoad( heapSizeA ), 1 );
+        auto minThresholdC = ConstantInt::get( i64T, GC_MIN_THRESHOLD );
+        builder.CreateStore( builder.CreateSelect( builder.CreateICmpUGT( liveSizeV, minThresholdC ), liveSizeV, minThresholdC ),
+                             this->lookup_llvm_value( "tx.runtime.GC_THRESHOLD" ) );
+
+        auto pauseV = builder.CreateSub( builder.CreateCall( clockFuncA, {} ), startTimeV, "pause" );
+        gen_gc_add_stat( builder, this->lookup_llvm_value( "tx.runtime.GC_COLLECTIONS" ), ConstantInt::get( i64T, 1 ) );
+        gen_gc_add_stat( builder, this->lookup_llvm_value( "tx.runtime.GC_PAUSE_TOTAL" ), pauseV );
+        auto pauseMaxA = this->lookup_llvm_value( "tx.runtime.GC_PAUSE_MAX" );
+        auto pauseMaxV = builder.CreateLoad( pauseMaxA );
+        builder.CreateStore( builder.CreateSelect( builder.CreateICmpUGT( pauseV, pauseMaxV ), pauseV, pauseMaxV ), pauseMaxA );
+        builder.CreateRetVoid();
+    }
+}
+
+void LlvmGenerationContext::gen_gc_compare_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto headerPtrPtrT = PointerType::getUnqual( PointerType::getUnqual( this->gcHeaderT ) );
+    Function* function = this->llvmModule().getFunction( "$gc_compare" );
+    Function::arg_iterator args = function->arg_begin();
+    Value* aV = &( *args );
+    args++;
+    Value* bV = &( *args );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+    auto aAddrV = builder.CreatePtrToInt( builder.CreateLoad( builder.CreatePointerCast( aV, headerPtrPtrT ) ), i64T );
+    auto bAddrV = builder.CreatePtrToInt( builder.CreateLoad( builder.CreatePointerCast( bV, headerPtrPtrT ) ), i64T );
+    auto gtV = builder.CreateZExt( builder.CreateICmpUGT( aAddrV, bAddrV ), i32T );
+    auto ltV = builder.CreateZExt( builder.CreateICmpULT( aAddrV, bAddrV ), i32T );
+    builder.CreateRet( builder.CreateSub( gtV, ltV ) );
+}
+
+void LlvmGenerationContext::gen_gc_mark_ptr_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto headerPtrT = PointerType::getUnqual( this->gcHeaderT );
+    Function* function = this->llvmModule().getFunction( "$gc_mark_ptr" );
+    Value* ptrV = &( *function->arg_begin() );
+    ptrV->setName( "ptr" );
+
+    BasicBlock* entryBlock    = BasicBlock::Create( this->llvmContext, "entry",       function );
+    BasicBlock* searchCondBlock = BasicBlock::Create( this->llvmContext, "search_cond", function );
+    BasicBlock* searchBlock   = BasicBlock::Create( this->llvmContext, "search",      function );
+    BasicBlock* foundBlock    = BasicBlock::Create( this->llvmContext, "found",       function );
+    BasicBlock* candBlock     = BasicBlock::Create( this->llvmContext, "if_candidate", function );
+    BasicBlock* withinBlock   = BasicBlock::Create( this->llvmContext, "if_within",   function );
+    BasicBlock* unmarkedBlock = BasicBlock::Create( this->llvmContext, "if_unmarked", function );
+    BasicBlock* growBlock     = BasicBlock::Create( this->llvmContext, "if_full",     function );
+    BasicBlock* pushBlock     = BasicBlock::Create( this->llvmContext, "push",        function );
+    BasicBlock* doneBlock     = BasicBlock::Create( this->llvmContext, "done",        function );
+    IRBuilder<> builder( entryBlock );
+
+    auto oneC = ConstantInt::get( i64T, 1 );
+    auto addrV = builder.CreatePtrToInt( ptrV, i64T, "addr" );
+    auto tableV = builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.GC_TABLE" ), "table" );
+    // binary search for the first object whose header address is above the pointer:
+    auto loA = gen_var( builder, i64T, ConstantInt::get( i64T, 0 ), "lo" );
+    auto hiA = gen_var( builder, i64T, builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.GC_TABLE_SIZE" ) ), "hi" );
+    builder.CreateBr( searchCondBlock );
+    {
+        builder.SetInsertPoint( searchCondBlock );
+        builder.CreateCondBr( builder.CreateICmpULT( builder.CreateLoad( loA ), builder.CreateLoad( hiA ) ), searchBlock, foundBlock );
+    }
+    {
+        builder.SetInsertPoint( searchBlock );
+        auto loV = builder.CreateLoad( loA );
+        auto midV = builder.CreateLShr( builder.CreateAdd( loV, builder.CreateLoad( hiA ) ), 1, "mid" );
+        auto midAddrV = builder.CreatePtrToInt( builder.CreateLoad( builder.CreateInBoundsGEP( tableV, midV ) ), i64T );
+        auto belowV = builder.CreateICmpULE( midAddrV, addrV );
+        builder.CreateStore( builder.CreateSelect( belowV, builder.CreateAdd( midV, oneC ), loV ), loA );
+        builder.CreateStore( builder.CreateSelect( belowV, builder.CreateLoad( hiA ), midV ), hiA );
+        builder.CreateBr( searchCondBlock );
+    }
+    Value* headerV;
+    {
+        // the candidate is the last object whose header address is not above the pointer
+        // (there is none if the pointer is below all objects, or if the object table is empty):
+        builder.SetInsertPoint( foundBlock );
+        auto loV = builder.CreateLoad( loA );
+        builder.CreateCondBr( builder.CreateIsNull( loV ), doneBlock, candBlock );
+
+        builder.SetInsertPoint( candBlock );
+        headerV = builder.CreateLoad( builder.CreateInBoundsGEP( tableV, builder.CreateSub( loV, oneC ) ), "header" );
+        auto startV = builder.CreateAdd( builder.CreatePtrToInt( headerV, i64T ), ConstantInt::get( i64T, GC_HEADER_SIZE ) );
+        auto endV = builder.CreateAdd( startV, builder.CreateLoad( gen_gc_field_addr( builder, headerV, GC_SIZE ) ) );
+        auto withinV = builder.CreateAnd( builder.CreateICmpUGE( addrV, startV ), builder.CreateICmpULT( addrV, endV ) );
+        builder.CreateCondBr( withinV, withinBlock, doneBlock );
+    }
+    Value* markA;
+    {
+        builder.SetInsertPoint( withinBlock );
+        markA = gen_gc_field_addr( builder, headerV, GC_MARK );
+        builder.CreateCondBr( builder.CreateIsNull( builder.CreateLoad( markA ) ), unmarkedBlock, doneBlock );
+    }
+    auto markStackA = this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK" );
+    auto topA = this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK_TOP" );
+    auto capA = this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK_CAP" );
+    {
+        builder.SetInsertPoint( unmarkedBlock );
+        builder.CreateStore( ConstantInt::get( i32T, 1 ), markA );
+        builder.CreateCondBr( builder.CreateICmpEQ( builder.CreateLoad( topA ), builder.CreateLoad( capA ) ), growBlock, pushBlock );
+    }
+    {
+        builder.SetInsertPoint( growBlock );
+        auto newCapV = builder.CreateShl( builder.CreateLoad( capA ), 1 );
+        auto newSizeV = builder.CreateMul( newCapV, ConstantExpr::getSizeOf( headerPtrT ) );
+        auto oldStackV = builder.CreatePointerCast( builder.CreateLoad( markStackA ), this->voidPtrT );
+        auto newStackV = builder.CreateCall( this->llvmModule().getFunction( "realloc" ), { oldStackV, newSizeV } );
+        builder.CreateStore( builder.CreatePointerCast( newStackV, PointerType::getUnqual( headerPtrT ) ), markStackA );
+        builder.CreateStore( newCapV, capA );
+        builder.CreateBr( pushBlock );
+    }
+    {
+        builder.SetInsertPoint( pushBlock );
+        auto topV = builder.CreateLoad( topA );
+        builder.CreateStore( headerV, builder.CreateInBoundsGEP( builder.CreateLoad( markStackA ), topV ) );
+        builder.CreateStore( builder.CreateAdd( topV, oneC ), topA );
+        builder.CreateBr( doneBlock );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateRetVoid();
+    }
+}
+
+/** Generates a loop that conservatively marks every pointer-aligned word in the range [startV, endV). */
+static void gen_gc_mark_range( LlvmGenerationContext& context, IRBuilder<>& builder, Value* startV, Value* endV ) {
+    auto i64T = Type::getInt64Ty( context.llvmContext );
+    auto function = builder.GetInsertBlock()->getParent();
+    BasicBlock* condBlock = BasicBlock::Create( context.llvmContext, "scan_cond", function );
+    BasicBlock* loopBlock = BasicBlock::Create( context.llvmContext, "scan",      function );
+    BasicBlock* postBlock = BasicBlock::Create( context.llvmContext, "scan_post", function );
+
+    auto wordSizeC = ConstantInt::get( i64T, 8 );
+    auto startAddrV = builder.CreateAnd( builder.CreateAdd( builder.CreatePtrToInt( startV, i64T ), ConstantInt::get( i64T, 7 ) ),
+                                         ConstantInt::get( i64T, ~7ULL ) );
+    auto endAddrV = builder.CreatePtrToInt( endV, i64T );
+    // (the loop variable is allocated in the entry block since this may itself be within a loop)
+    IRBuilder<> entryBuilder( &function->getEntryBlock(), function->getEntryBlock().begin() );
+    auto addrA = entryBuilder.CreateAlloca( i64T, nullptr, "scanaddr" );
+    builder.CreateStore( startAddrV, addrA );
+    builder.CreateBr( condBlock );
+
+    builder.SetInsertPoint( condBlock );
+    auto addrV = builder.CreateLoad( addrA );
+    builder.CreateCondBr( builder.CreateICmpULE( builder.CreateAdd( addrV, wordSizeC ), endAddrV ), loopBlock, postBlock );
+
+    builder.SetInsertPoint( loopBlock );
+    auto wordV = builder.CreateLoad( builder.CreateIntToPtr( addrV, PointerType::getUnqual( context.get_voidPtrT() ) ) );
+    builder.CreateCall( context.llvmModule().getFunction( "$gc_mark_ptr" ), { wordV } );
+    builder.CreateStore( builder.CreateAdd( addrV, wordSizeC ), addrA );
+    builder.CreateBr( condBlock );
+
+    builder.SetInsertPoint( postBlock );
+}
+
+void LlvmGenerationContext::gen_gc_mark_stack_function() {
+    Function* function = this->llvmModule().getFunction( "$gc_mark_stack" );
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+
+    // the stack grows downwards from main()'s frame:
+    auto frameAddrF = Intrinsic::getDeclaration( &this->llvmModule(), Intrinsic::frameaddress );
+    auto frameV = builder.CreateCall( frameAddrF, { ConstantInt::get( i32T, 0 ) }, "frame" );
+    auto baseV = builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.GC_STACK_BASE" ), "base" );
+    gen_gc_mark_range( *this, builder, frameV, baseV );
+
+    // mutable globals (static fields) may also hold references:
+    for ( auto & global : this->llvmModule().globals() ) {
+        if ( global.isConstant() || global.isDeclaration() || global.getName().startswith( "tx.runtime." ) )
+            continue;
+        auto startV = builder.CreatePointerCast( &global, this->voidPtrT );
+        auto endV = builder.CreatePointerCast( builder.CreateConstGEP1_32( &global, 1 ), this->voidPtrT );
+        gen_gc_mark_range( *this, builder, startV, endV );
+    }
+    builder.CreateRetVoid();
+}
+
+void LlvmGenerationContext::gen_gc_trace_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto int8T = Type::getInt8Ty( this->llvmContext );
+    Function* function = this->llvmModule().getFunction( "$gc_trace" );
+
+    BasicBlock* entryBlock     = BasicBlock::Create( this->llvmContext, "entry",         function );
+    BasicBlock* condBlock      = BasicBlock::Create( this->llvmContext, "cond",          function );
+    BasicBlock* popBlock       = BasicBlock::Create( this->llvmContext, "pop",           function );
+    BasicBlock* preciseBlock   = BasicBlock::Create( this->llvmContext, "if_precise",    function );
+    BasicBlock* conservBlock   = BasicBlock::Create( this->llvmContext, "if_conserv",    function );
+    BasicBlock* elemCondBlock  = BasicBlock::Create( this->llvmContext, "elem_cond",     function );
+    BasicBlock* elemBlock      = BasicBlock::Create( this->llvmContext, "elem",          function );
+    BasicBlock* refCondBlock   = BasicBlock::Create( this->llvmContext, "ref_cond",      function );
+    BasicBlock* refBlock       = BasicBlock::Create( this->llvmContext, "ref",           function );
+    BasicBlock* elemNextBlock  = BasicBlock::Create( this->llvmContext, "elem_next",     function );
+    BasicBlock* doneBlock      = BasicBlock::Create( this->llvmContext, "done",          function );
+    IRBuilder<> builder( entryBlock );
+
+    auto zeroC = ConstantInt::get( i64T, 0 );
+    auto oneC = ConstantInt::get( i64T, 1 );
+    auto markStackA = this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK" );
+    auto topA = this->lookup_llvm_value( "tx.runtime.GC_MARK_STACK_TOP" );
+    auto markPtrF = this->llvmModule().getFunction( "$gc_mark_ptr" );
+    auto elemIxA = gen_var( builder, i64T, zeroC, "elemix" );
+    auto refIxA = gen_var( builder, i64T, zeroC, "refix" );
+    builder.CreateBr( condBlock );
+    {
+        builder.SetInsertPoint( condBlock );
+        builder.CreateCondBr( builder.CreateIsNull( builder.CreateLoad( topA ) ), doneBlock, popBlock );
+    }
+    Value* headerV;
+    Value* objV;
+    Value* refMapV;
+    Value* refCountV;
+    Value* elemCountV;
+    Value* elemSizeV;
+    {
+        builder.SetInsertPoint( popBlock );
+        auto topV = builder.CreateSub( builder.CreateLoad( topA ), oneC );
+        builder.CreateStore( topV, topA );
+        headerV = builder.CreateLoad( builder.CreateInBoundsGEP( builder.CreateLoad( markStackA ), topV ), "header" );
+        objV = builder.CreateInBoundsGEP( builder.CreatePointerCast( headerV, this->voidPtrT ), ConstantInt::get( i64T, GC_HEADER_SIZE ), "obj" );
+        auto typeIdV = builder.CreateLoad( gen_gc_field_addr( builder, headerV, GC_TYPEID ), "typeid" );
+
+        Value* mapIxs[] = { ConstantInt::get( i32T, 0 ), typeIdV };
+        refMapV = builder.CreateLoad( builder.CreateInBoundsGEP( this->lookup_llvm_value( "tx.runtime.TYPE_REFMAPS" ), mapIxs ), "refmap" );
+        auto rawCountV = builder.CreateLoad( builder.CreateStructGEP( nullptr, refMapV, 0 ) );
+        refCountV = builder.CreateZExt( rawCountV, i64T, "refcount" );
+
+        // array objects have the element count at offset 4 and the elements from offset 8:
+        auto typeClassV = builder.CreateLoad( builder.CreateInBoundsGEP( this->lookup_llvm_value( "tx.runtime.TYPE_CLASSES" ), mapIxs ) );
+        auto isArrayV = builder.CreateICmpEQ( typeClassV, ConstantInt::get( int8T, TXTC_ARRAY ) );
+        auto lengthA = builder.CreatePointerCast( builder.CreateConstInBoundsGEP1_32( int8T, objV, 4 ), PointerType::getUnqual( i32T ) );
+        elemCountV = builder.CreateSelect( isArrayV, builder.CreateZExt( builder.CreateLoad( lengthA ), i64T ), oneC, "elemcount" );
+        Value* infoIxs[] = { ConstantInt::get( i32T, 0 ), typeIdV, ConstantInt::get( i32T, 1 ) };
+        auto instanceSizeV = builder.CreateLoad( builder.CreateInBoundsGEP( this->lookup_llvm_value( "tx.runtime.TYPE_INFOS" ), infoIxs ) );
+        elemSizeV = builder.CreateZExt( instanceSizeV, i64T, "elemsize" );
+        objV = builder.CreateSelect( isArrayV, builder.CreateConstInBoundsGEP1_32( int8T, objV, 8 ), objV );
+        builder.CreateStore( zeroC, elemIxA );
+
+        auto conservativeV = builder.CreateICmpEQ( rawCountV, ConstantInt::get( i32T, GC_CONSERVATIVE_MAP ) );
+        builder.CreateCondBr( conservativeV, conservBlock, preciseBlock );
+    }
+    {   // the type's layout isn't statically known, scan the whole object:
+        builder.SetInsertPoint( conservBlock );
+        auto startV = builder.CreateInBoundsGEP( builder.CreatePointerCast( headerV, this->voidPtrT ), ConstantInt::get( i64T, GC_HEADER_SIZE ) );
+        auto endV = builder.CreateInBoundsGEP( startV, builder.CreateLoad( gen_gc_field_addr( builder, headerV, GC_SIZE ) ) );
+        gen_gc_mark_range( *this, builder, startV, endV );
+        builder.CreateBr( condBlock );
+    }
+    {
+        builder.SetInsertPoint( preciseBlock );
+        builder.CreateBr( elemCondBlock );
+
+        builder.SetInsertPoint( elemCondBlock );
+        auto condV = builder.CreateAnd( builder.CreateICmpULT( builder.CreateLoad( elemIxA ), elemCountV ),
+                                        builder.CreateIsNotNull( refCountV ) );
+        builder.CreateCondBr( condV, elemBlock, condBlock );
+    }
+    Value* elemV;
+    {
+        builder.SetInsertPoint( elemBlock );
+        elemV = builder.CreateInBoundsGEP( objV, builder.CreateMul( builder.CreateLoad( elemIxA ), elemSizeV ), "elem" );
+        builder.CreateStore( zeroC, refIxA );
+        builder.CreateBr( refCondBlock );
+    }
+    {
+        builder.SetInsertPoint( refCondBlock );
+        builder.CreateCondBr( builder.CreateICmpULT( builder.CreateLoad( refIxA ), refCountV ), refBlock, elemNextBlock );
+    }
+    {
+        builder.SetInsertPoint( refBlock );
+        auto refIxV = builder.CreateLoad( refIxA );
+        Value* offIxs[] = { ConstantInt::get( i32T, 0 ), ConstantInt::get( i32T, 2 ), refIxV };
+        auto offsetV = builder.CreateLoad( builder.CreateInBoundsGEP( refMapV, offIxs ) );
+        auto refA = builder.CreatePointerCast( builder.CreateInBoundsGEP( elemV, builder.CreateZExt( offsetV, i64T ) ),
+                                               PointerType::getUnqual( this->voidPtrT ) );
+        builder.CreateCall( markPtrF, { builder.CreateLoad( refA ) } );
+        builder.CreateStore( builder.CreateAdd( refIxV, oneC ), refIxA );
+        builder.CreateBr( refCondBlock );
+    }
+    {
+        builder.SetInsertPoint( elemNextBlock );
+        builder.CreateStore( builder.CreateAdd( builder.CreateLoad( elemIxA ), oneC ), elemIxA );
+        builder.CreateBr( elemCondBlock );
+    }
+    {
+        builder.SetInsertPoint( doneBlock );
+        builder.CreateRetVoid();
+    }
+}
+
+void LlvmGenerationContext::gen_gc_report_function() {
+    Function* function = this->llvmModule().getFunction( "$gc_report" );
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+
+    auto fprintfF = get_fprintf_function( *this );
+    auto stderrA = this->llvmModule().getOrInsertGlobal( "stderr", this->voidPtrT );
+
+    auto formatC = this->gen_const_cstring_chars_address(
+            "GC: %lu collections, total pause %lu us, max pause %lu us; peak heap %lu bytes, live %lu bytes in %lu objects, freed %lu bytes\n" );
+    auto load_stat = [&]( const std::string& name ) -> Value* {
+        return builder.CreateLoad( this->lookup_llvm_value( "tx.runtime." + name ) );
+    };
+    // (clock() is in microseconds on POSIX systems)
+    std::vector<Value*> args {
+            builder.CreateLoad( stderrA ), formatC,
+            load_stat( "GC_COLLECTIONS" ), load_stat( "GC_PAUSE_TOTAL" ), load_stat( "GC_PAUSE_MAX" ),
+            load_stat( "GC_PEAK_SIZE" ), load_stat( "GC_HEAP_SIZE" ), load_stat( "GC_OBJECT_COUNT" ), load_stat( "GC_FREED_SIZE" ),
+    };
+    builder.CreateCall( fprintfF, args );
+    builder.CreateRetVoid();
+}
+
+
+/** Adds the offsets of the references contained in instances of the specified type, located at the specified base offset.
+ * Returns false if the type's layout is not statically known to the extent that its instances need to be scanned conservatively.
+ */
+static bool add_gc_ref_offsets( LlvmGenerationContext& context, const TxActualType* acttype, Constant* baseOffsetC,
+                                std::vector<Constant*>& offsets ) {
+    switch ( acttype->get_type_class() ) {
+    case TXTC_ELEMENTARY:
+        return true;
+    case TXTC_REFERENCE:
+        offsets.push_back( baseOffsetC );
+        return true;
+    case TXTC_FUNCTION:
+        // lambda objects hold a closure reference, extern-c function pointers don't
+        if ( auto lambdaT = dyn_cast<StructType>( context.get_llvm_type( acttype ) ) )
+            offsets.push_back( ConstantExpr::getAdd( baseOffsetC, ConstantExpr::getOffsetOf( lambdaT, 1 ) ) );
+        return true;
+    case TXTC_TUPLE:
+        if ( acttype->is_static() ) {
+            auto structT = cast<StructType>( context.get_llvm_type( acttype ) );
+            auto & fields = acttype->get_instance_fields().fields;
+            for ( unsigned fieldIx = 0; fieldIx < fields.size(); ++fieldIx ) {
+                auto fieldOffsetC = ConstantExpr::getAdd( baseOffsetC, ConstantExpr::getOffsetOf( structT, fieldIx ) );
+                if ( !add_gc_ref_offsets( context, fields.at( fieldIx )->qualtype()->type()->acttype(), fieldOffsetC, offsets ) )
+                    return false;
+            }
+            return true;
+        }
+        return false;
+    case TXTC_ARRAY:
+        // embedded arrays don't have a statically known length, unless their elements are references they can be skipped
+        return static_cast<const TxArrayType*>( acttype )->element_type()->type()->acttype()->get_type_class() == TXTC_ELEMENTARY;
+    default:
+        return false;
+    }
+}
+
+Constant* LlvmGenerationContext::gen_gc_type_refmap( const TxActualType* acttype ) {
+    std::vector<Constant*> offsets;
+    bool precise = true;
+    auto zeroOffsetC = ConstantInt::get( Type::getInt64Ty( this->llvmContext ), 0 );
+    if ( acttype->get_type_class() == TXTC_ARRAY ) {
+        // the reference map of an array type describes its element type
+        auto elemType = static_cast<const TxArrayType*>( acttype )->element_type()->type()->acttype();
+        precise = elemType->is_static() && add_gc_ref_offsets( *this, elemType, zeroOffsetC, offsets );
+    }
+    else if ( acttype->is_static() )
+        precise = add_gc_ref_offsets( *this, acttype, zeroOffsetC, offsets );
+    // (non-static, non-array data types are never allocated)
+
+    std::vector<Constant*> offsets32;
+    if ( precise ) {
+        for ( auto offsetC : offsets )
+            offsets32.push_back( ConstantExpr::getTrunc( offsetC, i32T ) );
+    }
+    auto countC = ConstantInt::get( i32T, ( precise ? offsets32.size() : GC_CONSERVATIVE_MAP ) );
+    auto offsetsT = ArrayType::get( i32T, offsets32.size() );
+    auto refMapT = StructType::get( i32T, i32T, offsetsT, NULL );
+    auto refMapC = ConstantStruct::get( refMapT, countC, countC, ConstantArray::get( offsetsT, offsets32 ), NULL );
+    std::string refMapName( acttype->get_declaration()->get_unique_full_name() + "$refmap" );
+    auto refMapGlobalC = new GlobalVariable( this->llvmModule(), refMapT, true, GlobalValue::ExternalLinkage, refMapC, refMapName );
+    return ConstantExpr::getBitCast( refMapGlobalC, superTypesPtrT );
+}
+
+
+/***** profiler *****/
+
+/* Runtime representation notes:
+ * When compiled with -profile, every generated function has a profile record holding its call count and
+ * its self and inclusive time, measured in cycles (llvm.readcyclecounter, i.e. rdtsc on x86).
+ * On entry a function reads the cycle counter and saves and resets the running "child cycles" total; on exit
+ * it adds its elapsed time minus its children's time to its self time, and its elapsed time to the child
+ * cycles total of its caller. The inclusive time is only added when the outermost activation of a
+ * (recursive) function returns, so that it isn't counted several times.
+ * Virtual dispatch sites have a record holding their call count, and the passed array bounds checks are counted.
+ * The records are listed in tables generated after all the program code, and main() writes the profile,
+ * sorted by self time and call count, to PROFILE_FILE when the user main function returns.
+ */
+
+/** the file the profile is written to (in the current directory) */
+static const char* PROFILE_FILE = "tx-profile.txt";
+
+/** field indices of the profile record */
+enum ProfRecordField {
+    PR_CALLS,        // the call count
+    PR_SELF,         // the cycles spent in the function itself
+    PR_TOTAL,        // the cycles spent in the function including its callees
+    PR_DEPTH,        // the current recursion depth
+    PR_NAME,         // the function / dispatch site name (C string)
+};
+
+static Value* gen_pr_field_addr( IRBuilder<>& builder, Value* recordPtrV, ProfRecordField field ) {
+    return builder.CreateStructGEP( recordPtrV->getType()->getPointerElementType(), recordPtrV, field );
+}
+
+/** Generates code that adds the specified value to an i64 field or global. */
+static void gen_pr_add( IRBuilder<>& builder, Value* statA, Value* valV ) {
+    builder.CreateStore( builder.CreateAdd( builder.CreateLoad( statA ), valV ), statA );
+}
+
+void LlvmGenerationContext::declare_profile_runtime() {
+    auto voidT = Type::getVoidTy( this->llvmContext );
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+
+    this->profRecordT = StructType::create( this->llvmContext, "tx.runtime.$ProfRecord" );
+    this->profRecordT->setBody( { i64T, i64T, i64T, i64T, this->voidPtrT } );
+
+    auto zeroC = ConstantInt::get( i64T, 0 );
+    for ( auto name : { "tx.runtime.PROF_START", "tx.runtime.PROF_CHILD_CYCLES", "tx.runtime.PROF_BOUNDS_CHECKS" } ) {
+        auto globalC = new GlobalVariable( this->llvmModule(), i64T, false, GlobalValue::InternalLinkage, zeroC, name );
+        this->register_llvm_value( globalC->getName(), globalC );
+    }
+
+    auto declare_function = [this]( const std::string& name, FunctionType* funcT ) {
+        auto function = cast<Function>( this->llvmModule().getOrInsertFunction( name, funcT ) );
+        function->setLinkage( GlobalValue::InternalLinkage );
+        return function;
+    };
+    declare_function( "$prof_report",     FunctionType::get( voidT, false ) );
+    declare_function( "$prof_compare",    FunctionType::get( i32T, { this->voidPtrT, this->voidPtrT }, false ) );
+}
+
+void LlvmGenerationContext::generate_profile_runtime() {
+    this->gen_profile_compare_function();
+    this->gen_profile_report_function();
+}
+
+Constant* LlvmGenerationContext::gen_profile_record( const std::string& name ) {
+    auto zeroC = ConstantInt::get( Type::getInt64Ty( this->llvmContext ), 0 );
+    auto nameC = ConstantExpr::getPointerCast( this->gen_const_cstring_chars_address( name ), this->voidPtrT );
+    auto recordC = ConstantStruct::get( this->profRecordT, { zeroC, zeroC, zeroC, zeroC, nameC } );
+    // (named within tx.runtime so that the garbage collector doesn't scan the records)
+    return new GlobalVariable( this->llvmModule(), this->profRecordT, false, GlobalValue::InternalLinkage, recordC,
+                               "tx.runtime.prof." + name );
+}
+
+void LlvmGenerationContext::gen_profile_function( Function* function, const std::string& name ) {
+    if ( !this->tuplexPackage.driver().get_options().profile || function->empty() )
+        return;
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto recordC = this->gen_profile_record( name );
+    this->profFunctionRecords.push_back( recordC );
+    auto cycleCounterF = Intrinsic::getDeclaration( &this->llvmModule(), Intrinsic::readcyclecounter );
+    auto childCyclesA = this->lookup_llvm_value( "tx.runtime.PROF_CHILD_CYCLES" );
+
+    // find the returns before the entry code is inserted:
+    std::vector<ReturnInst*> returns;
+    for ( auto & block : *function ) {
+        if ( auto returnInst = dyn_cast_or_null<ReturnInst>( block.getTerminator() ) )
+            returns.push_back( returnInst );
+    }
+
+    IRBuilder<> builder( &*function->getEntryBlock().getFirstInsertionPt() );
+    auto startV = builder.CreateCall( cycleCounterF, { }, "prof_start" );
+    auto savedChildCyclesV = builder.CreateLoad( childCyclesA, "prof_saved" );
+    builder.CreateStore( ConstantInt::get( i64T, 0 ), childCyclesA );
+    gen_pr_add( builder, gen_pr_field_addr( builder, recordC, PR_CALLS ), ConstantInt::get( i64T, 1 ) );
+    gen_pr_add( builder, gen_pr_field_addr( builder, recordC, PR_DEPTH ), ConstantInt::get( i64T, 1 ) );
+
+    for ( auto returnInst : returns ) {
+        builder.SetInsertPoint( returnInst );
+        auto elapsedV = builder.CreateSub( builder.CreateCall( cycleCounterF, { } ), startV, "prof_elapsed" );
+        gen_pr_add( builder, gen_pr_field_addr( builder, recordC, PR_SELF ), builder.CreateSub( elapsedV, builder.CreateLoad( childCyclesA ) ) );
+        auto depthA = gen_pr_field_addr( builder, recordC, PR_DEPTH );
+        auto depthV = builder.CreateSub( builder.CreateLoad( depthA ), ConstantInt::get( i64T, 1 ) );
+        builder.CreateStore( depthV, depthA );
+        auto outermostElapsedV = builder.CreateSelect( builder.CreateIsNull( depthV ), elapsedV, ConstantInt::get( i64T, 0 ) );
+        gen_pr_add( builder, gen_pr_field_addr( builder, recordC, PR_TOTAL ), outermostElapsedV );
+        builder.CreateStore( builder.CreateAdd( savedChildCyclesV, elapsedV ), childCyclesA );
+    }
+}
+
+void LlvmGenerationContext::gen_profile_dispatch_site( GenScope* scope, const TxNode* origin, const std::string& methodName ) {
+    if ( !this->tuplexPackage.driver().get_options().profile )
+        return;
+    std::stringstream siteName;
+    if ( origin ) {
+        if ( origin->ploc.begin.filename )
+            siteName << *origin->ploc.begin.filename;
+        siteName << ":" << origin->ploc.begin.line << ":" << origin->ploc.begin.column << " ";
+    }
+    siteName << methodName;
+    auto recordC = this->gen_profile_record( siteName.str() );
+    this->profSiteRecords.push_back( recordC );
+    gen_pr_add( *scope->builder, gen_pr_field_addr( *scope->builder, recordC, PR_CALLS ),
+                ConstantInt::get( Type::getInt64Ty( this->llvmContext ), 1 ) );
+}
+
+void LlvmGenerationContext::gen_profile_bounds_check( GenScope* scope ) {
+    if ( !this->tuplexPackage.driver().get_options().profile )
+        return;
+    gen_pr_add( *scope->builder, this->lookup_llvm_value( "tx.runtime.PROF_BOUNDS_CHECKS" ),
+                ConstantInt::get( Type::getInt64Ty( this->llvmContext ), 1 ) );
+}
+
+void LlvmGenerationContext::gen_profile_compare_function() {
+    auto recordPtrPtrT = PointerType::getUnqual( PointerType::getUnqual( this->profRecordT ) );
+    Function* function = this->llvmModule().getFunction( "$prof_compare" );
+    Function::arg_iterator args = function->arg_begin();
+    Value* aV = &( *args );
+    args++;
+    Value* bV = &( *args );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+    // descending order of self time, then of call count:
+    auto aRecordV = builder.CreateLoad( builder.CreatePointerCast( aV, recordPtrPtrT ) );
+    auto bRecordV = builder.CreateLoad( builder.CreatePointerCast( bV, recordPtrPtrT ) );
+    auto compare_field = [&]( ProfRecordField field ) -> Value* {
+        auto aFieldV = builder.CreateLoad( gen_pr_field_addr( builder, aRecordV, field ) );
+        auto bFieldV = builder.CreateLoad( gen_pr_field_addr( builder, bRecordV, field ) );
+        return builder.CreateSub( builder.CreateZExt( builder.CreateICmpULT( aFieldV, bFieldV ), i32T ),
+                                  builder.CreateZExt( builder.CreateICmpUGT( aFieldV, bFieldV ), i32T ) );
+    };
+    auto selfCmpV = compare_field( PR_SELF );
+    auto callsCmpV = compare_field( PR_CALLS );
+    builder.CreateRet( builder.CreateSelect( builder.CreateIsNull( selfCmpV ), callsCmpV, selfCmpV ) );
+}
+
+void LlvmGenerationContext::gen_profile_report_function() {
+    auto doubleT = Type::getDoubleTy( this->llvmContext );
+    auto recordPtrT = PointerType::getUnqual( this->profRecordT );
+    Function* function = this->llvmModule().getFunction( "$prof_report" );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    BasicBlock* writeBlock = BasicBlock::Create( this->llvmContext, "write", function );
+    BasicBlock* doneBlock  = BasicBlock::Create( this->llvmContext, "done",  function );
+    IRBuilder<> builder( entryBlock );
+
+    auto fprintfF = get_fprintf_function( *this );
+    auto cstring = [this]( const std::string& value ) {
+        return this->gen_const_cstring_chars_address( value );
+    };
+
+    auto totalCyclesV = builder.CreateSub( builder.CreateCall( Intrinsic::getDeclaration( &this->llvmModule(), Intrinsic::readcyclecounter ), { } ),
+                                           builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.PROF_START" ) ), "total" );
+    // (declared here, after the program code, since the tx.c module declares fopen and fclose with other signatures)
+    auto fopenF = this->llvmModule().getOrInsertFunction( "fopen", FunctionType::get( this->voidPtrT, { this->voidPtrT, this->voidPtrT }, false ) );
+    auto fcloseF = this->llvmModule().getOrInsertFunction( "fclose", FunctionType::get( i32T, { this->voidPtrT }, false ) );
+    auto fileV = builder.CreateCall( fopenF, { cstring( PROFILE_FILE ), cstring( "w" ) }, "file" );
+    builder.CreateCondBr( builder.CreateIsNull( fileV ), doneBlock, writeBlock );
+
+    builder.SetInsertPoint( writeBlock );
+    builder.CreateCall( fprintfF, { fileV, cstring( "Flat profile, %lu cycles total\n" ), totalCyclesV } );
+
+    auto compareF = this->llvmModule().getFunction( "$prof_compare" );
+    // prints the records that have been called:
+    auto gen_record_report = [&]( Value* recordV, BasicBlock* nextBlock, const std::string& format, bool withCycles ) {
+        auto callsV = builder.CreateLoad( gen_pr_field_addr( builder, recordV, PR_CALLS ) );
+        auto nameV = builder.CreateLoad( gen_pr_field_addr( builder, recordV, PR_NAME ) );
+        BasicBlock* rowBlock = BasicBlock::Create( this->llvmContext, "row", function );
+        builder.CreateCondBr( builder.CreateIsNull( callsV ), nextBlock, rowBlock );
+        builder.SetInsertPoint( rowBlock );
+        if ( withCycles ) {
+            auto selfV = builder.CreateLoad( gen_pr_field_addr( builder, recordV, PR_SELF ) );
+            auto inclV = builder.CreateLoad( gen_pr_field_addr( builder, recordV, PR_TOTAL ) );
+            auto selfPctV = builder.CreateFDiv( builder.CreateFMul( builder.CreateUIToFP( selfV, doubleT ), ConstantFP::get( doubleT, 100.0 ) ),
+                                                builder.CreateUIToFP( totalCyclesV, doubleT ) );
+            builder.CreateCall( fprintfF, { fileV, cstring( format ), selfPctV, selfV, inclV, callsV, nameV } );
+        }
+        else
+            builder.CreateCall( fprintfF, { fileV, cstring( format ), callsV, nameV } );
+        builder.CreateBr( nextBlock );
+    };
+
+    builder.CreateCall( fprintfF, { fileV, cstring( "\n  self%    self cycles    incl cycles        calls  function\n" ) } );
+    gen_sorted_records_loop( *this, builder, "tx.runtime.PROF_FUNCTIONS", recordPtrT, this->profFunctionRecords, compareF,
+                             [&]( Value* recordV, BasicBlock* nextBlock ) {
+        gen_record_report( recordV, nextBlock, "%7.2f %14lu %14lu %12lu  %s\n", true );
+    } );
+    builder.CreateCall( fprintfF, { fileV, cstring( "\n       calls  virtual dispatch site\n" ) } );
+    gen_sorted_records_loop( *this, builder, "tx.runtime.PROF_SITES", recordPtrT, this->profSiteRecords, compareF,
+                             [&]( Value* recordV, BasicBlock* nextBlock ) {
+        gen_record_report( recordV, nextBlock, "%12lu  %s\n", false );
+    } );
+    builder.CreateCall( fprintfF, { fileV, cstring( "\nPassed array bounds checks: %lu\n" ),
+                                    builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.PROF_BOUNDS_CHECKS" ) ) } );
+    builder.CreateCall( fcloseF, { fileV } );
+    builder.CreateBr( doneBlock );
+
+    builder.SetInsertPoint( doneBlock );
+    builder.CreateRetVoid();
+}
+
+
+/***** heap profiler *****/
+
+/* Runtime representation notes:
+ * When compiled with -heapprof, all heap allocations are made via $heapprof_alloc, which receives the allocated
+ * object's runtime type id and the allocation site's record, and then allocates as usual (from the dataspace or
+ * the collected heap). The allocation count and bytes are aggregated per data type (tx.runtime.HEAPPROF_TYPES,
+ * indexed by type id) and per allocation site. The site records also hold the type id of their last allocation.
+ * When the user main function returns, the types and sites are printed to stderr sorted by allocated bytes,
+ * with the type ids resolved to names via the type name table (tx.runtime.TYPE_NAMES).
+ */
+
+/** field indices of the heap statistics record */
+enum HeapStatField {
+    HS_COUNT,    // the allocation count
+    HS_BYTES,    // the allocated bytes
+    HS_TYPEID,   // the type id (of the type's allocations, or of the site's last allocation)
+    HS_SITE,     // the allocation site location (C string), null for type records
+};
+
+static Value* gen_hs_field_addr( IRBuilder<>& builder, Value* statPtrV, HeapStatField field ) {
+    return builder.CreateStructGEP( statPtrV->getType()->getPointerElementType(), statPtrV, field );
+}
+
+
+void LlvmGenerationContext::declare_heapprof_runtime() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    auto voidT = Type::getVoidTy( this->llvmContext );
+
+    this->heapStatT = StructType::create( this->llvmContext, "tx.runtime.$HeapStat" );
+    this->heapStatT->setBody( { i64T, i64T, i32T, this->voidPtrT } );
+
+    auto zeroC = ConstantInt::get( i64T, 0 );
+    std::vector<Constant*> typeStats;
+    for ( uint32_t typeId = 0; typeId < this->tuplexPackage.registry().data_types_count(); typeId++ ) {
+        typeStats.push_back( ConstantStruct::get( this->heapStatT, { zeroC, zeroC, ConstantInt::get( i32T, typeId ),
+                                                                     ConstantPointerNull::get( cast<PointerType>( this->voidPtrT ) ) } ) );
+    }
+    auto typeStatsT = ArrayType::get( this->heapStatT, typeStats.size() );
+    auto create_global = [this]( Type* type, Constant* initC, const std::string& name ) {
+        auto globalC = new GlobalVariable( this->llvmModule(), type, false, GlobalValue::InternalLinkage, initC, name );
+        this->register_llvm_value( globalC->getName(), globalC );
+    };
+    create_global( typeStatsT, ConstantArray::get( typeStatsT, typeStats ), "tx.runtime.HEAPPROF_TYPES" );
+    create_global( i64T, zeroC, "tx.runtime.HEAPPROF_COUNT" );
+    create_global( i64T, zeroC, "tx.runtime.HEAPPROF_BYTES" );
+
+    auto declare_function = [this]( const std::string& name, FunctionType* funcT ) {
+        auto function = cast<Function>( this->llvmModule().getOrInsertFunction( name, funcT ) );
+        function->setLinkage( GlobalValue::InternalLinkage );
+        return function;
+    };
+    auto statPtrT = PointerType::getUnqual( this->heapStatT );
+    declare_function( "$heapprof_alloc",   FunctionType::get( this->voidPtrT, { i64T, i32T, statPtrT }, false ) );
+    declare_function( "$heapprof_report",  FunctionType::get( voidT, false ) );
+    declare_function( "$heapprof_compare", FunctionType::get( i32T, { this->voidPtrT, this->voidPtrT }, false ) );
+}
+
+void LlvmGenerationContext::generate_heapprof_runtime() {
+    this->gen_heapprof_alloc_function();
+    this->gen_heapprof_compare_function();
+    this->gen_heapprof_report_function();
+}
+
+Constant* LlvmGenerationContext::gen_heapprof_site( const TxNode* origin, Value* typeIdV ) {
+    std::stringstream siteName;
+    if ( origin ) {
+        if ( origin->ploc.begin.filename )
+            siteName << *origin->ploc.begin.filename;
+        siteName << ":" << origin->ploc.begin.line << ":" << origin->ploc.begin.column;
+    }
+    else
+        siteName << "(built-in)";
+    auto zeroC = ConstantInt::get( Type::getInt64Ty( this->llvmContext ), 0 );
+    auto typeIdC = dyn_cast<ConstantInt>( typeIdV );
+    auto siteC = ConstantExpr::getPointerCast( this->gen_const_cstring_chars_address( siteName.str() ), this->voidPtrT );
+    auto recordC = ConstantStruct::get( this->heapStatT, { zeroC, zeroC, ( typeIdC ? typeIdC : ConstantInt::get( i32T, 0 ) ), siteC } );
+    // (named within tx.runtime so that the garbage collector doesn't scan the records)
+    auto siteRecordC = new GlobalVariable( this->llvmModule(), this->heapStatT, false, GlobalValue::InternalLinkage, recordC,
+                                           "tx.runtime.heapprof." + siteName.str() );
+    this->heapprofSiteRecords.push_back( siteRecordC );
+    return siteRecordC;
+}
+
+void LlvmGenerationContext::gen_heapprof_alloc_function() {
+    auto i64T = Type::getInt64Ty( this->llvmContext );
+    Function* function = this->llvmModule().getFunction( "$heapprof_alloc" );
+    Function::arg_iterator args = function->arg_begin();
+    Value* sizeV = &( *args );
+    sizeV->setName( "size" );
+    args++;
+    Value* typeIdV = &( *args );
+    typeIdV->setName( "typeId" );
+    args++;
+    Value* siteV = &( *args );
+    siteV->setName( "site" );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry",     function );
+    BasicBlock* typeBlock  = BasicBlock::Create( this->llvmContext, "if_type",   function );
+    BasicBlock* allocBlock = BasicBlock::Create( this->llvmContext, "alloc",     function );
+    IRBuilder<> builder( entryBlock );
+
+    auto oneC = ConstantInt::get( i64T, 1 );
+    gen_pr_add( builder, this->lookup_llvm_value( "tx.runtime.HEAPPROF_COUNT" ), oneC );
+    gen_pr_add( builder, this->lookup_llvm_value( "tx.runtime.HEAPPROF_BYTES" ), sizeV );
+    gen_pr_add( builder, gen_hs_field_addr( builder, siteV, HS_COUNT ), oneC );
+    gen_pr_add( builder, gen_hs_field_addr( builder, siteV, HS_BYTES ), sizeV );
+    builder.CreateStore( typeIdV, gen_hs_field_addr( builder, siteV, HS_TYPEID ) );
+    auto typeStatsA = this->lookup_llvm_value( "tx.runtime.HEAPPROF_TYPES" );
+    auto typeCountC = ConstantInt::get( i32T, typeStatsA->getType()->getPointerElementType()->getArrayNumElements() );
+    builder.CreateCondBr( builder.CreateICmpULT( typeIdV, typeCountC ), typeBlock, allocBlock );
+
+    builder.SetInsertPoint( typeBlock );
+    auto typeStatV = builder.CreateInBoundsGEP( typeStatsA, { ConstantInt::get( i32T, 0 ), typeIdV } );
+    gen_pr_add( builder, gen_hs_field_addr( builder, typeStatV, HS_COUNT ), oneC );
+    gen_pr_add( builder, gen_hs_field_addr( builder, typeStatV, HS_BYTES ), sizeV );
+    builder.CreateBr( allocBlock );
+
+    builder.SetInsertPoint( allocBlock );
+    if ( this->tuplexPackage.driver().get_options().use_gc )
+        builder.CreateRet( builder.CreateCall( this->llvmModule().getFunction( "$gc_alloc" ), { sizeV, typeIdV } ) );
+    else
+        builder.CreateRet( builder.CreateCall( this->llvmModule().getFunction( "$dataspace_alloc" ), { sizeV } ) );
+}
+
+void LlvmGenerationContext::gen_heapprof_compare_function() {
+    auto statPtrPtrT = PointerType::getUnqual( PointerType::getUnqual( this->heapStatT ) );
+    Function* function = this->llvmModule().getFunction( "$heapprof_compare" );
+    Function::arg_iterator args = function->arg_begin();
+    Value* aV = &( *args );
+    args++;
+    Value* bV = &( *args );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+    // descending order of allocated bytes, then of allocation count:
+    auto aStatV = builder.CreateLoad( builder.CreatePointerCast( aV, statPtrPtrT ) );
+    auto bStatV = builder.CreateLoad( builder.CreatePointerCast( bV, statPtrPtrT ) );
+    auto compare_field = [&]( HeapStatField field ) -> Value* {
+        auto aFieldV = builder.CreateLoad( gen_hs_field_addr( builder, aStatV, field ) );
+        auto bFieldV = builder.CreateLoad( gen_hs_field_addr( builder, bStatV, field ) );
+        return builder.CreateSub( builder.CreateZExt( builder.CreateICmpULT( aFieldV, bFieldV ), i32T ),
+                                  builder.CreateZExt( builder.CreateICmpUGT( aFieldV, bFieldV ), i32T ) );
+    };
+    auto bytesCmpV = compare_field( HS_BYTES );
+    auto countCmpV = compare_field( HS_COUNT );
+    builder.CreateRet( builder.CreateSelect( builder.CreateIsNull( bytesCmpV ), countCmpV, bytesCmpV ) );
+}
+
+void LlvmGenerationContext::gen_heapprof_report_function() {
+    auto statPtrT = PointerType::getUnqual( this->heapStatT );
+    Function* function = this->llvmModule().getFunction( "$heapprof_report" );
+
+    BasicBlock* entryBlock = BasicBlock::Create( this->llvmContext, "entry", function );
+    IRBuilder<> builder( entryBlock );
+
+    auto fprintfF = get_fprintf_function( *this );
+    auto fileV = builder.CreateLoad( this->llvmModule().getOrInsertGlobal( "stderr", this->voidPtrT ) );
+    auto typeNamesA = this->lookup_llvm_value( "tx.runtime.TYPE_NAMES" );
+    auto typeCountC = ConstantInt::get( i32T, typeNamesA->getType()->getPointerElementType()->getArrayNumElements() );
+    builder.CreateCall( fprintfF, { fileV, this->gen_const_cstring_chars_address( "Heap profile: %lu allocations, %lu bytes\n" ),
+                                    builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.HEAPPROF_COUNT" ) ),
+                                    builder.CreateLoad( this->lookup_llvm_value( "tx.runtime.HEAPPROF_BYTES" ) ) } );
+
+    auto compareF = this->llvmModule().getFunction( "$heapprof_compare" );
+    // prints the records that have allocated, with the type id resolved via the type name table:
+    auto gen_record_report = [&]( Value* statV, BasicBlock* nextBlock, const std::string& format, bool withSite ) {
+        auto allocCountV = builder.CreateLoad( gen_hs_field_addr( builder, statV, HS_COUNT ) );
+        BasicBlock* rowBlock = BasicBlock::Create( this->llvmContext, "row", function );
+        builder.CreateCondBr( builder.CreateIsNull( allocCountV ), nextBlock, rowBlock );
+        builder.SetInsertPoint( rowBlock );
+        auto bytesV = builder.CreateLoad( gen_hs_field_addr( builder, statV, HS_BYTES ) );
+        auto typeIdV = builder.CreateLoad( gen_hs_field_addr( builder, statV, HS_TYPEID ) );
+        auto validTypeIdV = builder.CreateICmpULT( typeIdV, typeCountC );
+        auto nameIxV = builder.CreateSelect( validTypeIdV, typeIdV, ConstantInt::get( i32T, 0 ) );
+        auto nameV = builder.CreateSelect( validTypeIdV,
+                                           builder.CreateLoad( builder.CreateInBoundsGEP( typeNamesA, { ConstantInt::get( i32T, 0 ), nameIxV } ) ),
+                                           this->gen_const_cstring_chars_address( "?" ) );
+        auto formatC = this->gen_const_cstring_chars_address( format );
+        if ( withSite ) {
+            auto siteV = builder.CreateLoad( gen_hs_field_addr( builder, statV, HS_SITE ) );
+            builder.CreateCall( fprintfF, { fileV, formatC, allocCountV, bytesV, siteV, nameV } );
+        }
+        else
+            builder.CreateCall( fprintfF, { fileV, formatC, allocCountV, bytesV, nameV } );
+        builder.CreateBr( nextBlock );
+    };
+
+    std::vector<Constant*> typeRecords;
+    auto typeStatsA = cast<Constant>( this->lookup_llvm_value( "tx.runtime.HEAPPROF_TYPES" ) );
+    for ( unsigned typeId = 0; typeId < typeStatsA->getType()->getPointerElementType()->getArrayNumElements(); typeId++ )
+        typeRecords.push_back( ConstantExpr::getInBoundsGetElementPtr( typeStatsA->getType()->getPointerElementType(), typeStatsA,
+                                                                      ArrayRef<Constant*>( { ConstantInt::get( i32T, 0 ),
+                                                                                             ConstantInt::get( i32T, typeId ) } ) ) );
+    builder.CreateCall( fprintfF, { fileV, this->gen_const_cstring_chars_address( "\n       count          bytes  type\n" ) } );
+    gen_sorted_records_loop( *this, builder, "tx.runtime.HEAPPROF_TYPE_TABLE", statPtrT, typeRecords, compareF,
+                             [&]( Value* statV, BasicBlock* nextBlock ) {
+        gen_record_report( statV, nextBlock, "%12lu %14lu  %s\n", false );
+    } );
+    builder.CreateCall( fprintfF, { fileV, this->gen_const_cstring_chars_address(
+            "\n       count          bytes  allocation site (last allocated type)\n" ) } );
+    gen_sorted_records_loop( *this, builder, "tx.runtime.HEAPPROF_SITE_TABLE", statPtrT, this->heapprofSiteRecords, compareF,
+                             [&]( Value* statV, BasicBlock* nextBlock ) {
+        gen_record_report( statV, nextBlock, "%12lu %14lu  %s (%s)\n", true );
+    } );
+    builder.CreateRetVoid();
+}
@@ -50,7 +50,7 @@ int main( int argc, char **argv )
                 printf( "  %-22s %s\n", "-da", "Dump AST" );
                 printf( "  %-22s %s\n", "-ds", "Dump symbol table" );
                 printf( "  %-22s %s\n", "-dsx", "Dump full symbol table including built-in symbols" );
-                printf( "  %-22s %s\n", "-dt", "Dump types" );
+                printf( "  %-22s %s\n", "-dt", "Dump types, and the instance size and padding of tuple types" );
                 printf( "  %-22s %s\n", "-di", "Dump intermediate representation (LLVM IR)" );
                 printf( "  %-22s %s\n", "-dl", "Print debugging output from lexer (token scanner)" );
                 printf( "  %-22s %s\n", "-dy", "Print debugging output from grammar parser" );
@@ -58,11 +58,19 @@ int main( int argc, char **argv )
                 printf( "  %-22s %s\n", "-ver", "Run generated code verifier after successful compilation" );
                 printf( "  %-22s %s\n", "-nojit", "Disable running program in JIT mode after successful compilation (default if release build)" );
                 printf( "  %-22s %s\n", "-jit", "Run program in JIT mode after successful compilation" );
+                printf( "  %-22s %s\n", "-jit-profile", "Register the JIT-compiled code with profilers (perf map file) and debuggers (GDB JIT interface)" );
                 printf( "  %-22s %s\n", "-nobc", "Don't output bitcode (and if also running in JIT mode, exit with program's return code)" );
                 printf( "  %-22s %s\n", "-bc", "Output bitcode file (default if release build)" );
                 printf( "  %-22s %s\n", "-onlyparse", "Stop after grammar parse" );
                 printf( "  %-22s %s\n", "-sepjobs", "Compile each command line source file as a separate compilation job" );
                 printf( "  %-22s %s\n", "-cnoassert", "Suppress code generation for assert statements" );
+                printf( "  %-22s %s\n", "-thinrefs", "Represent references with statically exact target type as plain pointers" );
+                printf( "  %-22s %s\n", "-gc", "Allocate objects on a garbage collected heap and print collector statistics on exit" );
+                printf( "  %-22s %s\n", "-g", "Generate debug info (source line locations, functions and local variables)" );
+                printf( "  %-22s %s\n", "-profile", "Instrument the program to write a flat function profile to tx-profile.txt on exit" );
+                printf( "  %-22s %s\n", "-heapprof", "Instrument the heap allocations and print the allocations per type and site on exit" );
+                printf( "  %-22s %s\n", "-fprofile-generate", "Instrument the bitcode to write LLVM profile data (link with the LLVM profile runtime, e.g. clang -fprofile-generate)" );
+                printf( "  %-22s %s\n", "-fprofile-use=<file>", "Optimize using LLVM profile data (as merged by llvm-profdata), including devirtualization of hot calls" );
                 // unofficial option  printf( "  %-22s %s\n", "-allowtx", "Permit source code to declare within the tx namespace" );
                 printf( "  %-22s %s\n", "-notx", "Exclude the tx namespace source code (basic built-in definitions will still exist)" );
                 printf( "  %-22s %s\n", "-tx <path>", "Location of the tx directory containing the tx namespace source code (default is .)" );
@@ -101,6 +109,8 @@ int main( int argc, char **argv )
                 options.run_jit = false;
             else if ( !strcmp( argv[a], "-jit" ) )
                 options.run_jit = true;
+            else if ( !strcmp( argv[a], "-jit-profile" ) )
+                options.jit_profile = true;
             else if ( !strcmp( argv[a], "-nobc" ) )
                 options.no_bc_output = true;
             else if ( !strcmp( argv[a], "-bc" ) )
@@ -111,6 +121,20 @@ int main( int argc, char **argv )
                 separateJobs = true;
             else if ( !strcmp( argv[a], "-cnoassert" ) )
                 options.suppress_asserts = true;
+            else if ( !strcmp( argv[a], "-thinrefs" ) )
+                options.thin_refs = true;
+            else if ( !strcmp( argv[a], "-gc" ) )
+                options.use_gc = true;
+            else if ( !strcmp( argv[a], "-g" ) )
+                options.debug_info = true;
+            else if ( !strcmp( argv[a], "-profile" ) )
+                options.profile = true;
+            else if ( !strcmp( argv[a], "-heapprof" ) )
+                options.heap_profile = true;
+            else if ( !strcmp( argv[a], "-fprofile-generate" ) )
+                options.profile_generate = true;
+            else if ( !strncmp( argv[a], "-fprofile-use=", strlen( "-fprofile-use=" ) ) )
+                options.profileUseFile = argv[a] + strlen( "-fprofile-use=" );
             else if ( !strcmp( argv[a], "-allowtx" ) )
                 options.allow_tx = true;
             else if ( !strcmp( argv[a], "-notx" ) )
@@ -134,6 +134,7 @@ YY_DECL;
 %token KW_NULL KW_TRUE KW_FALSE
 %token KW_PANIC KW_ASSERT KW_EXPERR
 %token KW__ADDRESS KW__TYPEID KW__SIZEOF KW__SUPERTYPES
+%token KW__COPY KW__APPEND KW__FILL
 
 /* keywords reserved but not currently used */
 %token KW_PUBLIC KW_PROTECTED
@@ -189,7 +190,7 @@ YY_DECL;
 %type <TxSuiteNode*> suite
 %type <TxStatementNode*> statement single_statement assignment_stmt return_stmt break_stmt continue_stmt type_decl_stmt
 %type <TxStatementNode*> flow_stmt simple_stmt elementary_stmt terminal_stmt flow_else_stmt
-%type <TxStatementNode*> assert_stmt panic_stmt experr_stmt
+%type <TxStatementNode*> assert_stmt panic_stmt experr_stmt intrinsics_stmt
 %type <TxElseClauseNode*> else_clause
 %type <TxFlowHeaderNode*> cond_clause is_clause in_clause for_header
 %type <std::vector<TxFlowHeaderNode*> *> in_clause_list
@@ -705,6 +706,7 @@ elementary_stmt
     |   assignment_stmt { $$ = $1; }
     |   assert_stmt     { $$ = $1; }
     |   panic_stmt      { $$ = $1; }
+    |   intrinsics_stmt { $$ = $1; }
     ;
 
 terminal_stmt
@@ -798,6 +800,16 @@ assert_stmt : KW_ASSERT expr  { $$ = new TxAssertStmtNode(@$, $2); }
 panic_stmt : KW_PANIC expr  { $$ = new TxPanicStmtNode(@$, $2); }
            ;
 
+intrinsics_stmt : KW__COPY LPAREN expr COMMA expr COMMA expr COMMA expr COMMA expr RPAREN
+                        { $$ = new TxArrayRangeCopyStmtNode(@$, $3, $5, $7, $9, $11); }
+                | KW__APPEND LPAREN expr COMMA expr RPAREN
+                        { $$ = new TxArrayRangeCopyStmtNode(@$, $3, nullptr, $5, nullptr, nullptr); }
+                | KW__APPEND LPAREN expr COMMA expr COMMA expr COMMA expr RPAREN
+                        { $$ = new TxArrayRangeCopyStmtNode(@$, $3, nullptr, $5, $7, $9); }
+                | KW__FILL LPAREN expr COMMA expr COMMA expr COMMA expr RPAREN
+                        { $$ = new TxArrayFillStmtNode(@$, $3, $5, $7, $9); }
+                ;
+
 
 assignment_stmt //:    assignee_pattern EQUAL expr
                 :    assignee_expr EQUAL expr  { $$ = new TxAssignStmtNode(@$, $1, $3); }
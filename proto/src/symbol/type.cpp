@@ -339,6 +339,42 @@ bool TxActualType::prepare_members() {
     return false;
 }
 
+/** Returns the (target independent) alignment of instances of the specified type when embedded as a field.
+ * Types whose layout isn't known yet are assumed to have pointer alignment. */
+static uint32_t get_field_alignment( const TxActualType* type ) {
+    switch ( type->get_type_class() ) {
+    case TXTC_ELEMENTARY:
+        if ( auto scalarType = dynamic_cast<const TxScalarType*>( type ) )
+            return scalarType->size();
+        if ( auto vecType = dynamic_cast<const TxVectorType*>( type ) ) {
+            // LLVM aligns vectors to their full size
+            if ( auto lanes = vecType->lanes() )
+                return lanes * get_field_alignment( vecType->element_type()->type()->acttype() );
+            return 8;
+        }
+        return 1;  // Bool
+    case TXTC_ARRAY:
+        return std::max( 4U, get_field_alignment( static_cast<const TxArrayType*>( type )->element_type()->type()->acttype() ) );
+    case TXTC_TUPLE: {
+        uint32_t alignment = 1;
+        for ( auto field : type->get_instance_fields().fields )
+            alignment = std::max( alignment, get_field_alignment( field->qualtype()->type()->acttype() ) );
+        return alignment;
+    }
+    default:
+        return 8;  // references, lambdas, and types resolved to unknown types
+    }
+}
+
+/** Returns true if the specified type or any of its base types is declared externc, and thus keeps the C field layout. */
+static bool has_c_layout( const TxActualType* type ) {
+    for ( ; type; type = type->get_base_type() ) {
+        if ( type->get_declaration()->get_decl_flags() & TXD_EXTERNC )
+            return true;
+    }
+    return false;
+}
+
 bool TxActualType::inner_prepare_members() {
     LOG_TRACE( this->LOGGER(), "Preparing members of type " << this );
     bool recursionError = false;
@@ -355,6 +391,8 @@ bool TxActualType::inner_prepare_members() {
         this->virtualFields = baseType->virtualFields;
         this->instanceFields = baseType->instanceFields;
     }
+    // the base type's instance fields are a layout prefix of this type's instance fields:
+    uint32_t baseFieldCount = this->instanceFields.get_field_count();
     for ( auto & interf : this->interfaces ) {
         //ASSERT(interfSpec.type->is_prepared(), "Base i/f " << interfSpec.type << " not prepared before sub type " << this);
         recursionError |= const_cast<TxActualType*>( interf )->prepare_members();
@@ -439,7 +477,8 @@ bool TxActualType::inner_prepare_members() {
                 else if ( !( !expErrField || expErrWholeType ) )
                     LOG_DEBUG( this->LOGGER(), "Skipping layout of exp-error instance field: " << field );
 
-                else if ( fieldDecl->get_decl_flags() & TXD_GENBINDING ) {
+                else if ( ( fieldDecl->get_decl_flags() & TXD_GENBINDING ) && this->instanceFields.has_field( field->get_unique_name() ) ) {
+                    // (VALUE bindings of individually code-generated specializations don't override an inherited field)
                     ASSERT( this->instanceFields.get_field( field->get_unique_name() )->get_decl_flags() & TXD_GENPARAM,
                             "Previous instance field entry is not a GENPARAM: " << this->instanceFields.get_field( field->get_unique_name() ) );
                     this->instanceFields.override_field( field );
@@ -508,6 +547,14 @@ bool TxActualType::inner_prepare_members() {
         }
     }
 
+    if ( this->get_type_class() == TXTC_TUPLE && !has_c_layout( this ) ) {
+        // minimize padding by laying out the fields added by this type in order of decreasing alignment
+        // (externc types keep the declaration order, i.e. the C layout)
+        this->instanceFields.sort_fields( baseFieldCount, []( const TxField* a, const TxField* b ) {
+            return get_field_alignment( a->qualtype()->type()->acttype() ) > get_field_alignment( b->qualtype()->type()->acttype() );
+        } );
+    }
+
     // (note, this condition is not the same as is_concrete())
     if ( !this->is_abstract() && this->get_type_class() != TXTC_INTERFACEADAPTER
          && !( this->get_declaration()->get_decl_flags() & TXD_GENPARAM ) ) {
@@ -710,6 +757,8 @@ bool TxActualType::is_leaf_derivation() const {
         return false;
 
     case TXTC_ELEMENTARY:
+        if ( dynamic_cast<const TxVectorType*>( this ) )
+            return !this->is_generic();
         switch ( this->runtimeTypeId ) {
         case TXBT_BYTE:
         case TXBT_SHORT:
@@ -1261,6 +1310,45 @@ const TxQualType* TxReferenceType::target_type() const {
     return this->get_root_any_qtype();  // we know the basic constraint type for ref target is Any
 }
 
+
+/*=== VectorType implementation ===*/
+
+bool TxVectorType::inner_prepare_members() {
+    bool rec = TxActualType::inner_prepare_members();
+    if ( !this->is_type_generic_dependent() && !this->lanes() )
+        CERROR( this, "Vec lane count is not bound to a statically constant value: " << this );
+    return rec;
+}
+
+bool TxVectorType::inner_is_assignable_to( const TxActualType* destination ) const {
+    // (vectors are elementary, so the destination may be a scalar type)
+    if ( auto toVec = dynamic_cast<const TxVectorType*>( destination ) ) {
+        if ( !this->element_type()->type()->acttype()->is_assignable_to( *toVec->element_type()->type()->acttype() ) )
+            return false;
+        return ( toVec->lanes() == 0 || toVec->lanes() == this->lanes() );
+    }
+    return false;
+}
+
+uint32_t TxVectorType::lanes() const {
+    if ( auto bindingDecl = this->lookup_value_param_binding( "tx.Vec.N" ) ) {
+        auto lanesExpr = bindingDecl->get_definer()->get_init_expression();
+        if ( lanesExpr && lanesExpr->is_statically_constant() )
+            return eval_unsigned_int_constant( lanesExpr );
+    }
+    return 0;
+}
+
+const TxQualType* TxVectorType::element_type() const {
+    if ( auto entSym = lookup_inherited_member( this->get_declaration()->get_symbol(), this, "tx#Vec#E" ) ) {
+        if ( auto typeDecl = entSym->get_type_decl() ) {
+            return typeDecl->get_definer()->resolve_type();
+        }
+    }
+    LOG( this->LOGGER(), ERROR, "tx#Vec#E not found in " << this );
+    return this->get_root_any_qtype();
+}
+
 bool TxInterfaceAdapterType::inner_prepare_members() {
     bool rec = TxActualType::inner_prepare_members();
 
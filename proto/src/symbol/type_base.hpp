@@ -43,6 +43,14 @@ public:
         this->fields.push_back( field );
     }
 
+    /** Stably sorts the fields from the specified index onwards according to the specified comparison. */
+    template<class Compare>
+    void sort_fields( uint32_t startIx, Compare comp ) {
+        std::stable_sort( this->fields.begin() + startIx, this->fields.end(), comp );
+        for ( uint32_t ix = startIx; ix < this->fields.size(); ix++ )
+            this->fieldMap[this->fields[ix]->get_unique_name()] = ix;
+    }
+
     /** Overrides an existing field name of this tuple with a new field definition. */
     void override_field( const TxField* field ) {
         auto index = this->fieldMap.at( field->get_unique_name() );
@@ -603,7 +611,10 @@ public:
 
     virtual llvm::Value* gen_alloca( LlvmGenerationContext& context, GenScope* scope, unsigned alignment, const std::string &varName = "" ) const;
     virtual llvm::Value* gen_alloca( LlvmGenerationContext& context, GenScope* scope, const std::string &varName = "" ) const;
-    virtual llvm::Value* gen_malloc( LlvmGenerationContext& context, GenScope* scope, const std::string &varName = "" ) const;
+    /** Generates a heap allocation of an instance of this type.
+     * @param origin the node the allocation is generated for */
+    virtual llvm::Value* gen_malloc( LlvmGenerationContext& context, GenScope* scope, const TxNode* origin,
+                                     const std::string &varName = "" ) const;
 
     /*--- to string methods ---*/
 
@@ -4,6 +4,8 @@
 #include "ast/expr/ast_ref.hpp"
 #include "llvm_generator.hpp"
 #include "tx_except.hpp"
+#include "package.hpp"
+#include "driver.hpp"
 
 using namespace llvm;
 
@@ -95,7 +97,7 @@ Value* TxActualType::gen_alloca( LlvmGenerationContext& context, GenScope* scope
     return this->gen_alloca( context, scope, 0, varName );
 }
 
-Value* TxActualType::gen_malloc( LlvmGenerationContext& context, GenScope* scope, const std::string &varName ) const {
+Value* TxActualType::gen_malloc( LlvmGenerationContext& context, GenScope* scope, const TxNode* origin, const std::string &varName ) const {
     if ( !this->is_static() ) {
         if ( this->is_concrete() )
             CERR_CODECHECK( this, "Currently not supported: Non-array types with VALUE bindings that are not statically constant: " << this );
@@ -103,7 +105,7 @@ Value* TxActualType::gen_malloc( LlvmGenerationContext& context, GenScope* scope
             THROW_LOGIC( "Attempted to codegen size of non-concrete type " << this );
     }
     Type* llvmType = context.get_llvm_type( this );
-    Value* objPtrV = context.gen_malloc( scope, llvmType );
+    Value* objPtrV = context.gen_malloc( scope, origin, llvmType, this->gen_typeid( context ) );
     this->initialize_specialized_obj( context, scope, objPtrV );
     return objPtrV;
 }
@@ -158,6 +160,27 @@ llvm::Type* TxFloatingType::get_scalar_llvm_type( LlvmGenerationContext& context
 }
 
 
+Type* TxVectorType::make_llvm_type( LlvmGenerationContext& context ) const {
+    auto elemType = this->element_type()->type()->acttype();
+    auto lanes = this->lanes();
+    if ( lanes == 0 || !( dynamic_cast<const TxScalarType*>( elemType ) || dynamic_cast<const TxBoolType*>( elemType ) ) ) {
+        // Generic vectors with unspecified element type or lane count can't be instantiated,
+        // they are mapped as void so they can be referenced from e.g. references.
+        LOG_DEBUG( context.LOGGER(), "Mapping generic vector type " << this << " -> void" );
+        return Type::getVoidTy( context.llvmContext );
+    }
+    if ( ( lanes & ( lanes - 1 ) ) || lanes > MAX_LANES )
+        CERR_CODECHECK( this, "Vec lane count must be a power of two no greater than " << MAX_LANES << ": " << lanes );
+    auto llvmType = VectorType::get( context.get_llvm_type( elemType ), lanes );
+    LOG_DEBUG( context.LOGGER(), "Mapping vector type " << this << " -> " << str(llvmType) );
+    return llvmType;
+}
+
+Type* TxVectorType::make_llvm_externc_type( LlvmGenerationContext& context ) const {
+    // vectors are passed as LLVM vectors, which is the C ABI of the equivalent vector extension types
+    return this->make_llvm_type( context );
+}
+
 
 Type* TxArrayType::make_llvm_type( LlvmGenerationContext& context ) const {
     //std::cout << "ArrayType make_llvm_type() " << ((void*)this) << std::endl;
@@ -203,7 +226,7 @@ static void initialize_array_obj( LlvmGenerationContext& context, GenScope* scop
         Value* ixs[] = { ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ),
                          ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 ) };
         auto capField = scope->builder->CreateInBoundsGEP( arrayObjPtrV, ixs );
-        scope->builder->CreateStore( arrayCap, capField );
+        LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateStore( arrayCap, capField ), context.get_tbaa_array_header_tag( 0 ) );
     }
 
     { // initialize length field:
@@ -211,7 +234,7 @@ static void initialize_array_obj( LlvmGenerationContext& context, GenScope* scop
                          ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 1 ) };
         auto lenField = scope->builder->CreateInBoundsGEP( arrayObjPtrV, ixs );
         auto zeroVal = ConstantInt::get( Type::getInt32Ty( context.llvmContext ), 0 );
-        scope->builder->CreateStore( zeroVal, lenField );
+        LlvmGenerationContext::set_tbaa_tag( scope->builder->CreateStore( zeroVal, lenField ), context.get_tbaa_array_header_tag( 1 ) );
     }
 }
 
@@ -311,7 +334,7 @@ Value* TxArrayType::gen_alloca( LlvmGenerationContext& context, GenScope* scope,
     return arrayObjPtrV;
 }
 
-Value* TxArrayType::gen_malloc( LlvmGenerationContext& context, GenScope* scope, const std::string &varName ) const {
+Value* TxArrayType::gen_malloc( LlvmGenerationContext& context, GenScope* scope, const TxNode* origin, const std::string &varName ) const {
     ASSERT( !this->is_generic(), "Attempted to malloc generic array type " << this );
     auto capField = this->instanceFields.fields.at( 0 );
     ASSERT( capField->get_unique_name() == "C", "Expected Array's first instance field to be C but is: " << capField );
@@ -325,7 +348,7 @@ Value* TxArrayType::gen_malloc( LlvmGenerationContext& context, GenScope* scope,
         CERR_CODECHECK( this, "Arrays with non-statically sized element type not supported: " << elemType );
 
     if ( capExpr->is_statically_constant() ) {
-        return TxActualType::gen_malloc( context, scope, varName );  // we assume malloc will provide alignment of at least 8
+        return TxActualType::gen_malloc( context, scope, origin, varName );  // we assume malloc will provide alignment of at least 8
     }
 
     // If size not statically constant, the llvm type will indicate zero array length and thus not describe the full size of the allocation.
@@ -336,7 +359,7 @@ Value* TxArrayType::gen_malloc( LlvmGenerationContext& context, GenScope* scope,
     Value* objectSizeV = gen_compute_array_size( context, scope, elemSizeC, arrayCap64V );
 
     // allocate array object:
-    Value* allocationPtr = context.gen_malloc( scope, objectSizeV );  // we assume malloc will provide alignment of at least 8
+    Value* allocationPtr = context.gen_malloc( scope, origin, objectSizeV, this->gen_typeid( context ) );  // we assume malloc will provide alignment of at least 8
 
     // cast the pointer:
     Type* llvmType = context.get_llvm_type( this );
@@ -349,6 +372,18 @@ Value* TxArrayType::gen_malloc( LlvmGenerationContext& context, GenScope* scope,
     return arrayObjPtrV;
 }
 
+/** Returns true if the runtime type of all instances referenced via the specified target type is statically known,
+ * i.e. the target type is a concrete elementary or final tuple type. */
+static bool is_exact_ref_target( const TxActualType* targetType ) {
+    switch ( targetType->get_type_class() ) {
+    case TXTC_ELEMENTARY:
+    case TXTC_TUPLE:
+        return targetType->is_leaf_derivation() && !targetType->is_generic() && targetType->has_runtime_type_id();
+    default:
+        return false;
+    }
+}
+
 Type* TxReferenceType::make_llvm_type( LlvmGenerationContext& context ) const {
     auto txTargetType = this->target_type();
     if ( !txTargetType )
@@ -358,6 +393,11 @@ Type* TxReferenceType::make_llvm_type( LlvmGenerationContext& context ) const {
         // happens when the target type was resolved to Any
         targetType = Type::getInt8Ty( context.llvmContext );  // i8* represents void*
     }
+    auto targetActType = txTargetType->type()->acttype();
+    if ( context.tuplexPackage.driver().get_options().thin_refs && is_exact_ref_target( targetActType ) ) {
+        // the type id is statically known, represent the reference with only the target pointer
+        return context.get_thin_ref_llvm_type( targetActType, targetType );
+    }
     return make_ref_llvm_type( context, targetType );
 }
 
@@ -41,7 +41,8 @@ public:
     virtual llvm::Constant* gen_static_size( LlvmGenerationContext& context ) const override;
 
     virtual llvm::Value* gen_alloca( LlvmGenerationContext& context, GenScope* scope, const std::string &varName = "" ) const override;
-    virtual llvm::Value* gen_malloc( LlvmGenerationContext& context, GenScope* scope, const std::string &varName = "" ) const override;
+    virtual llvm::Value* gen_malloc( LlvmGenerationContext& context, GenScope* scope, const TxNode* origin,
+                                     const std::string &varName = "" ) const override;
 };
 
 /** Note, all reference specializations are mutable. */
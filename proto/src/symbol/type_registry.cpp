@@ -22,6 +22,10 @@
 static const TxDeclarationFlags DECL_FLAG_FILTER = TXD_VIRTUAL | TXD_PUBLIC | TXD_PROTECTED | TXD_ABSTRACT | TXD_FINAL | TXD_IMPLICIT
                                                    | TXD_EXPERRBLOCK;
 
+/** VALUE specializations where all the bound values are statically constant and not greater than this
+ * get individually code-generated specializations (with the values as compile-time constants) */
+static const uint32_t MAX_INDIVIDUALLY_SPECIALIZED_VALUE = 4;
+
 Logger& TypeRegistry::_LOG = Logger::get( "REGISTRY" );
 
 TypeRegistry::TypeRegistry( TxPackage& package )
@@ -628,6 +632,7 @@ const TxActualType* TypeRegistry::make_type_specialization( const TxTypeDefining
 
     // create binding declaration nodes:
     bool typeBindings = false;
+    bool smallConstValueBindings = true;
     auto bindingDeclNodes = new std::vector<TxDeclarationNode*>();
     for ( unsigned ix = 0; ix < bindings->size(); ix++ ) {
         auto binding = bindings->at( ix );
@@ -647,6 +652,9 @@ const TxActualType* TypeRegistry::make_type_specialization( const TxTypeDefining
             auto valueArg = static_cast<const TxValueTypeArgumentNode*>( binding );
             bindingDeclNodes->push_back( make_value_type_param_decl_node( valueArg->get_parse_location(), paramName,
                                                                           TXD_GENBINDING | TXD_PUBLIC, paramDecl, valueArg->valueExprNode ) );
+            if ( !( valueArg->valueExprNode->is_statically_constant()
+                    && eval_unsigned_int_constant( valueArg->valueExprNode ) <= MAX_INDIVIDUALLY_SPECIALIZED_VALUE ) )
+                smallConstValueBindings = false;
             LOG_TRACE( this->LOGGER(), "Re-bound base type " << baseDecl->get_unique_full_name() << " parameter '" << paramName
                        << "' with " << valueArg->valueExprNode );
         }
@@ -681,6 +689,12 @@ const TxActualType* TypeRegistry::make_type_specialization( const TxTypeDefining
     TxTypeExpressionNode* specTypeExpr;
     if ( typeBindings )
         specTypeExpr = baseTypeExpr->make_ast_copy();
+    else if ( smallConstValueBindings && !( baseDecl->get_decl_flags() & TXD_BUILTIN ) ) {
+        // small constant VALUE bindings get a distinct AST copy, so that code is generated with the values as constants
+        // (built-in types such as Array are implemented with statically known sizes if the values are constant)
+        LOG_DEBUG( this->LOGGER(), "Individually specializing " << baseDecl->get_unique_full_name() << " as " << newSpecTypeNameStr );
+        specTypeExpr = baseTypeExpr->make_ast_copy();
+    }
     else {
         // shallow specialization when only VALUE params are bound
         auto shallowBaseTypeExpr = new TxTypeDeclWrapperNode( definer->get_parse_location(), baseDecl );
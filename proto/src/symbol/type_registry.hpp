@@ -129,6 +129,11 @@ public:
     /** to be invoked after the resolution pass has been run on package's source, and before type registration */
     void deferred_type_resolution_pass();
 
+    /** Returns true once the resolution passes have completed and the type preparation phase has started. */
+    bool is_preparing_types() const {
+        return this->startedPreparingTypes;
+    }
+
     /** Gets the enqueued specialization ASTs (e.g. for running code generation on them) */
     const std::vector<TxTypeDeclNode*>& get_enqueued_specializations() const {
         return this->enqueuedSpecializations;
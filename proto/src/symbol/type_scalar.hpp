@@ -103,3 +103,38 @@ public:
 
     virtual llvm::Type* get_scalar_llvm_type( LlvmGenerationContext& context ) const override;
 };
+
+/** The built-in SIMD vector type Vec<E,N>, a fixed number (N) of lanes of an elementary element type (E).
+ * It is represented as an LLVM vector, and its operations map to SIMD instructions where the target has them.
+ * The lane count must be a statically constant power of two.
+ */
+class TxVectorType final : public TxActualType {
+protected:
+    virtual TxVectorType* make_specialized_type( const TxTypeDeclaration* declaration, const TxActualType* baseType,
+                                                 bool mutableType, const std::vector<const TxActualType*>& interfaces ) const override {
+        if ( !dynamic_cast<const TxVectorType*>( baseType ) )
+            throw std::logic_error( "Specified a base type for TxVectorType that was not a TxVectorType: " + baseType->str() );
+        return new TxVectorType( declaration, baseType, interfaces );
+    }
+
+    virtual bool inner_prepare_members() override;
+
+    virtual bool inner_is_assignable_to( const TxActualType* other ) const override;
+
+public:
+    /** The maximum number of lanes of a vector type. */
+    static const uint32_t MAX_LANES = 64;
+
+    TxVectorType( const TxTypeDeclaration* declaration, const TxActualType* baseType, const std::vector<const TxActualType*>& interfaces )
+            : TxActualType( TXTC_ELEMENTARY, declaration, baseType, true, interfaces ) {
+    }
+
+    /** Returns the element type if bound, or tx.Vec.E generic type parameter if unbound. */
+    const TxQualType* element_type() const;
+
+    /** Returns the lane count if it is bound to a statically constant value, otherwise 0. */
+    uint32_t lanes() const;
+
+    virtual llvm::Type* make_llvm_type( LlvmGenerationContext& context ) const override;
+    virtual llvm::Type* make_llvm_externc_type( LlvmGenerationContext& context ) const override;
+};
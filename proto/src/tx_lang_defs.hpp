@@ -38,6 +38,7 @@ enum BuiltinTypeId
     TXBT_ARRAY,
     TXBT_FUNCTION,
     TXBT_TUPLE,
+    TXBT_VECTOR,
     BuiltinTypeId_COUNT,
     TXBT_NOTSET = UINT32_MAX
 };